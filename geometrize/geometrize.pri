@@ -1,3 +1,5 @@
+CONFIG += c++14
+
 INCLUDEPATH += $$PWD
 
 HEADERS += $$files($$PWD/geometrize/*.h, true)
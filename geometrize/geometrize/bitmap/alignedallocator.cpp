@@ -0,0 +1,71 @@
+#include "alignedallocator.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+#if defined(__linux__) && defined(GEOMETRIZE_HUGE_PAGES)
+#include <sys/mman.h>
+#define GEOMETRIZE_ADVISE_HUGE_PAGES 1
+#endif
+
+namespace
+{
+
+#ifdef GEOMETRIZE_ADVISE_HUGE_PAGES
+const std::size_t hugePageSize{2U * 1024U * 1024U}; ///< The size of a transparent huge page on x86-64 and most ARM64 kernels.
+#endif
+
+}
+
+namespace geometrize
+{
+
+void* allocateAligned(const std::size_t bytes, std::size_t alignment)
+{
+    assert(alignment != 0 && (alignment & (alignment - 1U)) == 0);
+
+#ifdef GEOMETRIZE_ADVISE_HUGE_PAGES
+    if(bytes >= hugePageSize) {
+        alignment = hugePageSize;
+    }
+#endif
+
+    // Let the platform align the block, so it can give back the slack in front of the aligned address rather than us holding on to it
+#if defined(_WIN32)
+    void* const block{_aligned_malloc(bytes, alignment)};
+#else
+    if(alignment < sizeof(void*)) {
+        alignment = sizeof(void*);
+    }
+    void* block{nullptr};
+    if(posix_memalign(&block, alignment, bytes) != 0) {
+        return nullptr;
+    }
+#endif
+
+#ifdef GEOMETRIZE_ADVISE_HUGE_PAGES
+    if(block != nullptr && bytes >= hugePageSize) {
+        // Only advise the whole huge pages inside the block. This is a hint, so failure (e.g. if huge pages are disabled) is harmless
+        madvise(block, bytes & ~(hugePageSize - 1U), MADV_HUGEPAGE);
+    }
+#endif
+
+    return block;
+}
+
+void freeAligned(void* const block)
+{
+#if defined(_WIN32)
+    _aligned_free(block);
+#else
+    std::free(block);
+#endif
+}
+
+}
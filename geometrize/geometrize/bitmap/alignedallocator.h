@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+namespace geometrize
+{
+
+/**
+ * @brief allocateAligned Allocates a block of memory whose address is a multiple of the given alignment. If GEOMETRIZE_HUGE_PAGES is defined, blocks
+ * of 2 MiB or more are aligned to and advised for huge pages where the platform supports it (Linux transparent huge pages).
+ * @param bytes The size of the block in bytes.
+ * @param alignment The alignment of the block, must be a power of two.
+ * @return The block, or nullptr if it could not be allocated. Must be freed with geometrize::freeAligned.
+ */
+void* allocateAligned(std::size_t bytes, std::size_t alignment);
+
+/**
+ * @brief freeAligned Frees a block allocated with geometrize::allocateAligned.
+ * @param block The block to free, may be nullptr.
+ */
+void freeAligned(void* block);
+
+/**
+ * @brief The AlignedAllocator class is a standard allocator that aligns its allocations to a cache line, so vectorized code can make
+ * aligned loads from the start of the data and the rows of a bitmap don't share a cache line with other allocations.
+ * @author Sam Twidale (https://samcodes.co.uk/)
+ */
+template<typename T>
+class AlignedAllocator
+{
+public:
+    typedef T value_type;
+
+    static const std::size_t alignment{64U}; ///< The alignment of the allocations in bytes.
+
+    AlignedAllocator() = default;
+
+    template<typename U>
+    AlignedAllocator(const geometrize::AlignedAllocator<U>&)
+    {}
+
+    T* allocate(const std::size_t count)
+    {
+        void* block{geometrize::allocateAligned(count * sizeof(T), alignment)};
+        if(block == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(block);
+    }
+
+    void deallocate(T* block, std::size_t)
+    {
+        geometrize::freeAligned(block);
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const geometrize::AlignedAllocator<T>&, const geometrize::AlignedAllocator<U>&)
+{
+    return true;
+}
+
+template<typename T, typename U>
+bool operator!=(const geometrize::AlignedAllocator<T>&, const geometrize::AlignedAllocator<U>&)
+{
+    return false;
+}
+
+}
@@ -1,18 +1,23 @@
 #include "bitmap.h"
 
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 #include "rgba.h"
 
 namespace geometrize
 {
 
-Bitmap::Bitmap(const std::uint32_t width, const std::uint32_t height, const geometrize::rgba color) : m_width{width}, m_height{height}, m_data(width * height * 4U)
+Bitmap::Bitmap(const std::uint32_t width, const std::uint32_t height, const geometrize::rgba color) :
+    m_width{width}, m_height{height}, m_stride{static_cast<std::size_t>(width) * 4U}, m_data(m_stride * height)
 {
     fill(color);
 }
 
-Bitmap::Bitmap(const std::uint32_t width, const std::uint32_t height, const std::vector<std::uint8_t>& data) : m_width{width}, m_height{height}, m_data{data}
+Bitmap::Bitmap(const std::uint32_t width, const std::uint32_t height, const std::vector<std::uint8_t>& data) :
+    m_width{width}, m_height{height}, m_stride{static_cast<std::size_t>(width) * 4U}, m_data(data.begin(), data.end())
 {
     assert((width * height * 4U) == data.size());
 }
@@ -29,27 +34,53 @@ std::uint32_t Bitmap::getHeight() const
 
 std::vector<std::uint8_t> Bitmap::copyData() const
 {
-    return m_data;
+    return std::vector<std::uint8_t>(m_data.begin(), m_data.end());
+}
+
+std::vector<std::uint8_t> Bitmap::getDataRef() const
+{
+    return copyData();
 }
 
-const std::vector<std::uint8_t>& Bitmap::getDataRef() const
+const std::uint8_t* Bitmap::getDataRef(std::size_t& size) const
+{
+    size = m_data.size();
+    return m_data.data();
+}
+
+const geometrize::Bitmap::Data& Bitmap::getData() const
 {
     return m_data;
 }
 
+std::size_t Bitmap::getStride() const
+{
+    return m_stride;
+}
+
+const std::uint8_t* Bitmap::row(const std::uint32_t y) const
+{
+    return m_data.data() + y * m_stride;
+}
+
+std::uint8_t* Bitmap::row(const std::uint32_t y)
+{
+    return m_data.data() + y * m_stride;
+}
+
 geometrize::rgba Bitmap::getPixel(const std::uint32_t x, const std::uint32_t y) const
 {
-    const std::size_t index{(m_width * y + x) * 4U};
-    return geometrize::rgba{m_data[index], m_data[index + 1U], m_data[index + 2U], m_data[index + 3U]};
+    const std::uint8_t* const pixel{row(y) + x * 4U};
+    return geometrize::rgba{pixel[0], pixel[1], pixel[2], pixel[3]};
 }
 
 void Bitmap::setPixel(const std::uint32_t x, const std::uint32_t y, const geometrize::rgba color)
 {
-    const std::uint32_t index{(m_width * y + x) * 4U};
-    m_data[index] = color.r;
-    m_data[index + 1U] = color.g;
-    m_data[index + 2U] = color.b;
-    m_data[index + 3U] = color.a;
+    std::uint8_t* const pixel{row(y) + x * 4U};
+    pixel[0] = color.r;
+    pixel[1] = color.g;
+    pixel[2] = color.b;
+    pixel[3] = color.a;
 }
 
 void Bitmap::fill(const geometrize::rgba color)
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
+#include "alignedallocator.h"
 #include "rgba.h"
 
 namespace geometrize
@@ -10,11 +12,15 @@ namespace geometrize
 
 /**
  * @brief The Bitmap class is a helper class for working with bitmap data.
+ * The pixels are stored row by row as RGBA8888 in a buffer aligned to a cache line, large bitmaps can be backed by huge pages (see geometrize::allocateAligned).
+ * Code that works on many pixels should get pointers to whole rows with row() and step through them, rather than going through getPixel and setPixel.
  * @author Sam Twidale (https://samcodes.co.uk/)
  */
 class Bitmap
 {
 public:
+    typedef std::vector<std::uint8_t, geometrize::AlignedAllocator<std::uint8_t>> Data; ///< The type of the buffer holding the bitmap data.
+
     /**
      * @brief Bitmap Creates a new bitmap.
      * @param width The width of the bitmap.
@@ -46,16 +52,55 @@ public:
     std::uint32_t getHeight() const;
 
     /**
-     * @brief copyData Gets a copy of the raw bitmap data.
+     * @brief copyData Gets a copy of the raw bitmap data, the rows are getStride() bytes apart.
      * @return The bitmap data.
      */
     std::vector<std::uint8_t> copyData() const;
 
     /**
-     * @brief getDataRef Gets a reference to the raw bitmap data.
+     * @brief getDataRef Gets a copy of the raw bitmap data, the rows are getStride() bytes apart.
+     * @deprecated The bitmap data is no longer held in a std::vector<std::uint8_t>, so this returns a copy of the whole bitmap on every call, the same as copyData().
+     * The copy is a temporary unless it is stored, so e.g. getDataRef().data() points to freed memory once the full expression ends.
+     * Use getData(), or getDataRef(std::size_t&) for a pointer to the pixels, to read the bitmap data without copying it.
+     * @return A copy of the bitmap data.
+     */
+    [[deprecated("Returns a copy of the bitmap data, use getData() or getDataRef(std::size_t&) instead")]]
+    std::vector<std::uint8_t> getDataRef() const;
+
+    /**
+     * @brief getDataRef Gets a pointer to the raw bitmap data, the rows are getStride() bytes apart.
+     * The pointer is to the bitmap's own data, so it stays valid for as long as the bitmap does and isn't assigned to.
+     * @param size Set to the size of the bitmap data in bytes.
+     * @return A pointer to the start of the bitmap data.
+     */
+    const std::uint8_t* getDataRef(std::size_t& size) const;
+
+    /**
+     * @brief getData Gets a reference to the raw bitmap data, the rows are getStride() bytes apart.
      * @return The bitmap data.
      */
-    const std::vector<std::uint8_t>& getDataRef() const;
+    const geometrize::Bitmap::Data& getData() const;
+
+    /**
+     * @brief getStride Gets the number of bytes from the start of one row of the bitmap to the start of the next.
+     * The rows are packed, so this is width * 4, but code that walks the rows should step by this rather than assume it.
+     * @return The row stride in bytes.
+     */
+    std::size_t getStride() const;
+
+    /**
+     * @brief row Gets a pointer to the first pixel of a row, the pixels of the row follow it as 4 bytes each.
+     * @param y The y-coordinate of the row.
+     * @return A pointer to the start of the row.
+     */
+    const std::uint8_t* row(std::uint32_t y) const;
+
+    /**
+     * @brief row Gets a pointer to the first pixel of a row, the pixels of the row follow it as 4 bytes each.
+     * @param y The y-coordinate of the row.
+     * @return A pointer to the start of the row.
+     */
+    std::uint8_t* row(std::uint32_t y);
 
     /**
      * @brief getPixel Gets a pixel color value.
@@ -82,7 +127,8 @@ public:
 private:
     std::uint32_t m_width; ///< The width of the bitmap.
     std::uint32_t m_height; ///< The height of the bitmap.
-    std::vector<std::uint8_t> m_data; ///< The bitmap data.
+    std::size_t m_stride; ///< The number of bytes between the starts of consecutive rows.
+    geometrize::Bitmap::Data m_data; ///< The bitmap data.
 };
 
 }
@@ -0,0 +1,159 @@
+#include "errormap.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "bitmap.h"
+#include "../commonutil.h"
+#include "../rasterizer/scanline.h"
+#include "../simd/kernels.h"
+
+namespace geometrize
+{
+
+ErrorMap::ErrorMap(const geometrize::Bitmap& target, const geometrize::Bitmap& current, const std::uint32_t cellSize) :
+    m_width{target.getWidth()},
+    m_height{target.getHeight()},
+    m_cellSize{cellSize},
+    m_columns{(target.getWidth() + cellSize - 1U) / cellSize},
+    m_rows{(target.getHeight() + cellSize - 1U) / cellSize},
+    m_errors(static_cast<std::size_t>(m_columns) * m_rows),
+    m_errorTree(m_errors.size() + 1U),
+    m_totalError{0}
+{
+    assert(cellSize > 0);
+    assert(target.getWidth() == current.getWidth());
+    assert(target.getHeight() == current.getHeight());
+    update(target, current);
+}
+
+std::uint32_t ErrorMap::getCellSize() const
+{
+    return m_cellSize;
+}
+
+std::uint32_t ErrorMap::getColumns() const
+{
+    return m_columns;
+}
+
+std::uint32_t ErrorMap::getRows() const
+{
+    return m_rows;
+}
+
+std::uint64_t ErrorMap::getCellError(const std::uint32_t column, const std::uint32_t row) const
+{
+    return m_errors[static_cast<std::size_t>(row) * m_columns + column];
+}
+
+std::uint64_t ErrorMap::getTotalError() const
+{
+    return m_totalError;
+}
+
+void ErrorMap::update(const geometrize::Bitmap& target, const geometrize::Bitmap& current)
+{
+    for(std::uint32_t row = 0; row < m_rows; row++) {
+        for(std::uint32_t column = 0; column < m_columns; column++) {
+            updateCell(target, current, column, row);
+        }
+    }
+    buildErrorTree();
+}
+
+void ErrorMap::updateCells(const geometrize::Bitmap& target, const geometrize::Bitmap& current, const std::vector<geometrize::Scanline>& lines)
+{
+    std::vector<std::size_t>& cells{m_touchedCells};
+    cells.clear();
+    for(const geometrize::Scanline& line : lines) {
+        if(line.x2 < line.x1) {
+            continue;
+        }
+        const std::size_t row{static_cast<std::size_t>(line.y) / m_cellSize};
+        for(std::size_t column = static_cast<std::size_t>(line.x1) / m_cellSize; column <= static_cast<std::size_t>(line.x2) / m_cellSize; column++) {
+            cells.push_back(row * m_columns + column);
+        }
+    }
+    std::sort(cells.begin(), cells.end());
+    cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+
+    // Only the touched cells change, so pass the change in each of their errors up the tree rather than rebuilding it
+    for(const std::size_t cell : cells) {
+        const std::uint64_t before{m_errors[cell]};
+        updateCell(target, current, static_cast<std::uint32_t>(cell % m_columns), static_cast<std::uint32_t>(cell / m_columns));
+        const std::uint64_t change{m_errors[cell] - before}; // Wraps around when the error falls, adding it wraps back
+        for(std::size_t i = cell + 1U; i < m_errorTree.size(); i += i & (~i + 1U)) {
+            m_errorTree[i] += change;
+        }
+        m_totalError += change;
+    }
+}
+
+std::pair<std::int32_t, std::int32_t> ErrorMap::samplePoint() const
+{
+    std::size_t cell{0};
+    const std::uint64_t total{getTotalError()};
+    if(total == 0) {
+        cell = static_cast<std::size_t>(geometrize::commonutil::randomRange(0, static_cast<std::int32_t>(m_errors.size()) - 1));
+    } else {
+        // Two draws make a 62-bit number, so the modulo bias is negligible for any realistic total
+        const std::uint64_t high{static_cast<std::uint64_t>(geometrize::commonutil::randomRange(0, INT32_MAX))};
+        const std::uint64_t low{static_cast<std::uint64_t>(geometrize::commonutil::randomRange(0, INT32_MAX))};
+        std::uint64_t value{((high << 31) | low) % total};
+
+        // Find the first cell whose running total exceeds the value, by descending the tree for the number of cells whose running total doesn't
+        std::size_t step{1};
+        while(step * 2U < m_errorTree.size()) {
+            step *= 2U;
+        }
+        for(; step > 0; step /= 2U) {
+            if(cell + step < m_errorTree.size() && m_errorTree[cell + step] <= value) {
+                cell += step;
+                value -= m_errorTree[cell];
+            }
+        }
+    }
+
+    const std::uint32_t x{static_cast<std::uint32_t>(cell % m_columns) * m_cellSize};
+    const std::uint32_t y{static_cast<std::uint32_t>(cell / m_columns) * m_cellSize};
+    return std::make_pair(
+        geometrize::commonutil::randomRange(static_cast<std::int32_t>(x), static_cast<std::int32_t>((std::min)(x + m_cellSize, m_width) - 1U)),
+        geometrize::commonutil::randomRange(static_cast<std::int32_t>(y), static_cast<std::int32_t>((std::min)(y + m_cellSize, m_height) - 1U)));
+}
+
+void ErrorMap::updateCell(const geometrize::Bitmap& target, const geometrize::Bitmap& current, const std::uint32_t column, const std::uint32_t row)
+{
+    const std::uint32_t x1{column * m_cellSize};
+    const std::uint32_t x2{(std::min)(x1 + m_cellSize, m_width)};
+    const std::uint32_t y1{row * m_cellSize};
+    const std::uint32_t y2{(std::min)(y1 + m_cellSize, m_height)};
+
+    std::int64_t error{0};
+    for(std::uint32_t y = y1; y < y2; y++) {
+        error += geometrize::simd::squaredError(target.row(y) + static_cast<std::size_t>(x1) * 4U, current.row(y) + static_cast<std::size_t>(x1) * 4U, x2 - x1);
+    }
+    m_errors[static_cast<std::size_t>(row) * m_columns + column] = static_cast<std::uint64_t>(error);
+}
+
+void ErrorMap::buildErrorTree()
+{
+    // Each node holds the sum of the cells below it, pass each node's sum up to its parent in one pass
+    m_totalError = 0;
+    for(std::size_t i = 1; i < m_errorTree.size(); i++) {
+        m_errorTree[i] = m_errors[i - 1U];
+        m_totalError += m_errors[i - 1U];
+    }
+    for(std::size_t i = 1; i < m_errorTree.size(); i++) {
+        const std::size_t parent{i + (i & (~i + 1U))};
+        if(parent < m_errorTree.size()) {
+            m_errorTree[parent] += m_errorTree[i];
+        }
+    }
+}
+
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace geometrize
+{
+class Bitmap;
+class Scanline;
+}
+
+namespace geometrize
+{
+
+/**
+ * @brief The ErrorMap class keeps the total squared error between a target and current bitmap pair over a grid of square cells.
+ * Points can be sampled from it in proportion to the error, so that new shapes are tried where the current bitmap matches the target worst.
+ * @author Sam Twidale (https://samcodes.co.uk/)
+ */
+class ErrorMap
+{
+public:
+    /**
+     * @brief ErrorMap Creates a new error map for the given bitmaps.
+     * @param target The target bitmap.
+     * @param current The current bitmap, must be the same size as the target.
+     * @param cellSize The width and height of the cells in pixels, must be greater than zero.
+     */
+    ErrorMap(const geometrize::Bitmap& target, const geometrize::Bitmap& current, std::uint32_t cellSize);
+
+    ~ErrorMap() = default;
+    ErrorMap& operator=(const geometrize::ErrorMap&) = default;
+    ErrorMap(const geometrize::ErrorMap&) = default;
+
+    /**
+     * @brief getCellSize Gets the width and height of the cells.
+     * @return The size of the cells in pixels.
+     */
+    std::uint32_t getCellSize() const;
+
+    /**
+     * @brief getColumns Gets the number of columns of cells, the last column may be narrower than the cell size.
+     * @return The number of columns.
+     */
+    std::uint32_t getColumns() const;
+
+    /**
+     * @brief getRows Gets the number of rows of cells, the last row may be shorter than the cell size.
+     * @return The number of rows.
+     */
+    std::uint32_t getRows() const;
+
+    /**
+     * @brief getCellError Gets the total squared error over the pixels in a cell.
+     * @param column The column of the cell.
+     * @param row The row of the cell.
+     * @return The sum of (t - c)^2 over every channel of every pixel in the cell.
+     */
+    std::uint64_t getCellError(std::uint32_t column, std::uint32_t row) const;
+
+    /**
+     * @brief getTotalError Gets the total squared error over the whole bitmap.
+     * @return The sum of the errors of all the cells.
+     */
+    std::uint64_t getTotalError() const;
+
+    /**
+     * @brief update Recalculates the error of every cell, e.g. after the current bitmap was reset or modified externally.
+     * @param target The target bitmap.
+     * @param current The current bitmap.
+     */
+    void update(const geometrize::Bitmap& target, const geometrize::Bitmap& current);
+
+    /**
+     * @brief updateCells Recalculates the error of the cells touched by the given scanlines.
+     * @param target The target bitmap.
+     * @param current The current bitmap.
+     * @param lines The scanlines that were drawn onto the current bitmap.
+     */
+    void updateCells(const geometrize::Bitmap& target, const geometrize::Bitmap& current, const std::vector<geometrize::Scanline>& lines);
+
+    /**
+     * @brief samplePoint Picks a random pixel, choosing a cell with probability proportional to its error and then a pixel uniformly within it.
+     * Uses the thread-local random number generators, so it's deterministic for a given seed. If there is no error at all every pixel is equally likely.
+     * @return The x and y coordinates of the pixel.
+     */
+    std::pair<std::int32_t, std::int32_t> samplePoint() const;
+
+private:
+    /**
+     * @brief updateCell Recalculates the error of one cell.
+     */
+    void updateCell(const geometrize::Bitmap& target, const geometrize::Bitmap& current, std::uint32_t column, std::uint32_t row);
+
+    /**
+     * @brief buildErrorTree Rebuilds the tree of partial sums of the cell errors used for sampling, from the errors of every cell.
+     */
+    void buildErrorTree();
+
+    std::uint32_t m_width; ///< The width of the bitmaps.
+    std::uint32_t m_height; ///< The height of the bitmaps.
+    std::uint32_t m_cellSize; ///< The width and height of the cells.
+    std::uint32_t m_columns; ///< The number of columns of cells.
+    std::uint32_t m_rows; ///< The number of rows of cells.
+    std::vector<std::uint64_t> m_errors; ///< The error of each cell, row by row.
+    std::vector<std::uint64_t> m_errorTree; ///< Fenwick tree over the cell errors, 1-based, so a cell's error can be changed and the running totals searched in O(log cells).
+    std::uint64_t m_totalError; ///< The sum of the errors of all the cells.
+    std::vector<std::size_t> m_touchedCells; ///< Scratch list of the cells touched by the scanlines passed to updateCells, kept to avoid reallocating it.
+};
+
+}
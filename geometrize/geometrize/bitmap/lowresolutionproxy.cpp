@@ -0,0 +1,110 @@
+#include "lowresolutionproxy.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bitmap.h"
+#include "rgba.h"
+#include "../commonutil.h"
+#include "../rasterizer/scanline.h"
+
+namespace geometrize
+{
+
+LowResolutionProxy::LowResolutionProxy(const geometrize::Bitmap& target, const geometrize::Bitmap& current, const std::uint32_t factor) :
+    m_factor{factor},
+    m_target{geometrize::commonutil::downsampleImage(target, factor)},
+    m_current{geometrize::commonutil::downsampleImage(current, factor)}
+{
+    assert(target.getWidth() == current.getWidth());
+    assert(target.getHeight() == current.getHeight());
+}
+
+std::uint32_t LowResolutionProxy::getFactor() const
+{
+    return m_factor;
+}
+
+const geometrize::Bitmap& LowResolutionProxy::getTarget() const
+{
+    return m_target;
+}
+
+const geometrize::Bitmap& LowResolutionProxy::getCurrent() const
+{
+    return m_current;
+}
+
+void LowResolutionProxy::update(const geometrize::Bitmap& current)
+{
+    m_current = geometrize::commonutil::downsampleImage(current, m_factor);
+}
+
+void LowResolutionProxy::updatePixels(const geometrize::Bitmap& current, const std::vector<geometrize::Scanline>& lines)
+{
+    for(const geometrize::Scanline& line : mapLines(lines)) {
+        for(std::int32_t x = line.x1; x <= line.x2; x++) {
+            updatePixel(current, static_cast<std::uint32_t>(x), static_cast<std::uint32_t>(line.y));
+        }
+    }
+}
+
+std::vector<geometrize::Scanline> LowResolutionProxy::mapLines(const std::vector<geometrize::Scanline>& lines) const
+{
+    std::vector<geometrize::Scanline> mapped;
+    mapped.reserve(lines.size() / m_factor + 1U);
+    mapLines(lines, mapped);
+    return mapped;
+}
+
+void LowResolutionProxy::mapLines(const std::vector<geometrize::Scanline>& lines, std::vector<geometrize::Scanline>& mapped) const
+{
+    const std::int32_t factor{static_cast<std::int32_t>(m_factor)};
+    mapped.clear();
+    for(const geometrize::Scanline& line : lines) {
+        if(line.x2 < line.x1) {
+            continue;
+        }
+        const geometrize::Scanline proxyLine(line.y / factor, line.x1 / factor, line.x2 / factor);
+        if(!mapped.empty()) {
+            geometrize::Scanline& last{mapped.back()};
+            if(last.y == proxyLine.y && proxyLine.x1 <= last.x2 + 1 && last.x1 <= proxyLine.x2 + 1) {
+                last.x1 = (std::min)(last.x1, proxyLine.x1);
+                last.x2 = (std::max)(last.x2, proxyLine.x2);
+                continue;
+            }
+        }
+        mapped.push_back(proxyLine);
+    }
+}
+
+void LowResolutionProxy::updatePixel(const geometrize::Bitmap& current, const std::uint32_t x, const std::uint32_t y)
+{
+    // Same averaging as commonutil::downsampleImage
+    const std::uint32_t width{current.getWidth()};
+    const std::uint32_t x2{(std::min)((x + 1U) * m_factor, width)};
+    const std::uint32_t y2{(std::min)((y + 1U) * m_factor, current.getHeight())};
+
+    std::uint32_t totals[4]{0, 0, 0, 0};
+    std::uint32_t count{0};
+    for(std::uint32_t fy = y * m_factor; fy < y2; fy++) {
+        const std::uint8_t* const data{current.row(fy)};
+        for(std::uint32_t fx = x * m_factor; fx < x2; fx++) {
+            for(std::size_t c = 0; c < 4U; c++) {
+                totals[c] += data[fx * 4U + c];
+            }
+            count++;
+        }
+    }
+    m_current.setPixel(x, y, geometrize::rgba{
+        static_cast<std::uint8_t>((totals[0] + count / 2U) / count),
+        static_cast<std::uint8_t>((totals[1] + count / 2U) / count),
+        static_cast<std::uint8_t>((totals[2] + count / 2U) / count),
+        static_cast<std::uint8_t>((totals[3] + count / 2U) / count)
+    });
+}
+
+}
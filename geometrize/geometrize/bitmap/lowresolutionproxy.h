@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "bitmap.h"
+
+namespace geometrize
+{
+class Scanline;
+}
+
+namespace geometrize
+{
+
+/**
+ * @brief The LowResolutionProxy class keeps downsampled copies of a target and current bitmap pair, for cheaply screening candidate shapes before scoring them exactly.
+ * Each proxy pixel is the average of a square block of full resolution pixels, as given by geometrize::commonutil::downsampleImage.
+ * @author Sam Twidale (https://samcodes.co.uk/)
+ */
+class LowResolutionProxy
+{
+public:
+    /**
+     * @brief LowResolutionProxy Creates downsampled copies of the given bitmaps.
+     * @param target The target bitmap.
+     * @param current The current bitmap, must be the same size as the target.
+     * @param factor The factor to downsample by, must be greater than zero.
+     */
+    LowResolutionProxy(const geometrize::Bitmap& target, const geometrize::Bitmap& current, std::uint32_t factor);
+
+    ~LowResolutionProxy() = default;
+    LowResolutionProxy& operator=(const geometrize::LowResolutionProxy&) = default;
+    LowResolutionProxy(const geometrize::LowResolutionProxy&) = default;
+
+    /**
+     * @brief getFactor Gets the factor the bitmaps are downsampled by.
+     * @return The downsampling factor.
+     */
+    std::uint32_t getFactor() const;
+
+    /**
+     * @brief getTarget Gets the downsampled target bitmap.
+     * @return The downsampled target bitmap.
+     */
+    const geometrize::Bitmap& getTarget() const;
+
+    /**
+     * @brief getCurrent Gets the downsampled current bitmap.
+     * @return The downsampled current bitmap.
+     */
+    const geometrize::Bitmap& getCurrent() const;
+
+    /**
+     * @brief update Rebuilds the downsampled current bitmap, e.g. after the current bitmap was reset or modified externally.
+     * @param current The current bitmap.
+     */
+    void update(const geometrize::Bitmap& current);
+
+    /**
+     * @brief updatePixels Rebuilds the downsampled current pixels covering the given scanlines.
+     * @param current The current bitmap.
+     * @param lines The scanlines that were drawn onto the current bitmap.
+     */
+    void updatePixels(const geometrize::Bitmap& current, const std::vector<geometrize::Scanline>& lines);
+
+    /**
+     * @brief mapLines Maps full resolution scanlines to the downsampled bitmaps, covering every proxy pixel whose block a scanline touches.
+     * Scanlines that fall on the same proxy row and overlap or touch there are merged, so consecutive rows of a shape don't cover a proxy pixel twice.
+     * @param lines The full resolution scanlines.
+     * @return The scanlines on the downsampled bitmaps.
+     */
+    std::vector<geometrize::Scanline> mapLines(const std::vector<geometrize::Scanline>& lines) const;
+
+    /**
+     * @brief mapLines Maps full resolution scanlines to the downsampled bitmaps as the overload above does, into a vector supplied by the caller.
+     * @param lines The full resolution scanlines.
+     * @param mapped The vector to put the scanlines on the downsampled bitmaps in, its contents are replaced.
+     */
+    void mapLines(const std::vector<geometrize::Scanline>& lines, std::vector<geometrize::Scanline>& mapped) const;
+
+private:
+    /**
+     * @brief updatePixel Recalculates one downsampled current pixel.
+     */
+    void updatePixel(const geometrize::Bitmap& current, std::uint32_t x, std::uint32_t y);
+
+    std::uint32_t m_factor; ///< The factor the bitmaps are downsampled by.
+    geometrize::Bitmap m_target; ///< The downsampled target bitmap.
+    geometrize::Bitmap m_current; ///< The downsampled current bitmap.
+};
+
+}
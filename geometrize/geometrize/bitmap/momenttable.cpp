@@ -0,0 +1,136 @@
+#include "momenttable.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bitmap.h"
+#include "pixelmoments.h"
+#include "../rasterizer/scanline.h"
+
+namespace geometrize
+{
+
+MomentTable::MomentTable(const geometrize::Bitmap& target, const geometrize::Bitmap& current) :
+    m_width{target.getWidth()},
+    m_height{target.getHeight()},
+    m_targetSums((target.getWidth() + 1U) * target.getHeight() * 4U),
+    m_currentSums(m_targetSums.size()),
+    m_targetSquares((target.getWidth() + 1U) * target.getHeight()),
+    m_currentSquares(m_targetSquares.size()),
+    m_crossProducts(m_targetSquares.size())
+{
+    assert(target.getWidth() == current.getWidth());
+    assert(target.getHeight() == current.getHeight());
+
+    for(std::uint32_t y = 0; y < m_height; y++) {
+        std::uint32_t* sums{&m_targetSums[static_cast<std::size_t>(y) * (m_width + 1U) * 4U]};
+        const std::uint8_t* row{target.row(y)};
+        std::uint64_t* squares{&m_targetSquares[static_cast<std::size_t>(y) * (m_width + 1U)]};
+        for(std::size_t x = 0; x < m_width; x++) {
+            std::uint32_t square{0};
+            for(std::size_t c = 0; c < 4U; c++) {
+                const std::uint32_t value{row[x * 4U + c]};
+                sums[(x + 1U) * 4U + c] = sums[x * 4U + c] + value;
+                square += value * value;
+            }
+            squares[x + 1U] = squares[x] + square;
+        }
+    }
+
+    update(target, current);
+}
+
+std::uint32_t MomentTable::getWidth() const
+{
+    return m_width;
+}
+
+std::uint32_t MomentTable::getHeight() const
+{
+    return m_height;
+}
+
+void MomentTable::update(const geometrize::Bitmap& target, const geometrize::Bitmap& current)
+{
+    for(std::uint32_t y = 0; y < m_height; y++) {
+        updateRow(target, current, y);
+    }
+}
+
+void MomentTable::updateRows(const geometrize::Bitmap& target, const geometrize::Bitmap& current, const std::vector<geometrize::Scanline>& lines)
+{
+    std::vector<std::int32_t> rows;
+    rows.reserve(lines.size());
+    for(const geometrize::Scanline& line : lines) {
+        rows.push_back(line.y);
+    }
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    for(const std::int32_t y : rows) {
+        if(y >= 0 && y < static_cast<std::int32_t>(m_height)) {
+            updateRow(target, current, static_cast<std::uint32_t>(y));
+        }
+    }
+}
+
+geometrize::PixelMoments MomentTable::getMoments(const std::vector<geometrize::Scanline>& lines) const
+{
+    geometrize::PixelMoments moments{{0, 0, 0, 0}, {0, 0, 0, 0}, 0, 0, 0, 0};
+    for(const geometrize::Scanline& line : lines) {
+        if(line.x2 < line.x1) {
+            continue;
+        }
+        const std::size_t first{static_cast<std::size_t>(line.y) * (m_width + 1U) + static_cast<std::size_t>(line.x1)};
+        const std::size_t last{static_cast<std::size_t>(line.y) * (m_width + 1U) + static_cast<std::size_t>(line.x2 + 1)};
+        for(std::size_t c = 0; c < 4U; c++) {
+            moments.target[c] += m_targetSums[last * 4U + c] - m_targetSums[first * 4U + c];
+            moments.current[c] += m_currentSums[last * 4U + c] - m_currentSums[first * 4U + c];
+        }
+        moments.targetSquares += m_targetSquares[last] - m_targetSquares[first];
+        moments.currentSquares += m_currentSquares[last] - m_currentSquares[first];
+        moments.crossProducts += m_crossProducts[last] - m_crossProducts[first];
+        moments.count += static_cast<std::uint64_t>(line.x2 - line.x1 + 1);
+    }
+    return moments;
+}
+
+std::uint64_t MomentTable::getSquaredError(const geometrize::Scanline& line) const
+{
+    if(line.x2 < line.x1) {
+        return 0;
+    }
+    const std::size_t first{static_cast<std::size_t>(line.y) * (m_width + 1U) + static_cast<std::size_t>(line.x1)};
+    const std::size_t last{static_cast<std::size_t>(line.y) * (m_width + 1U) + static_cast<std::size_t>(line.x2 + 1)};
+    const std::uint64_t targetSquares{m_targetSquares[last] - m_targetSquares[first]};
+    const std::uint64_t currentSquares{m_currentSquares[last] - m_currentSquares[first]};
+    const std::uint64_t crossProducts{m_crossProducts[last] - m_crossProducts[first]};
+    return targetSquares + currentSquares - 2U * crossProducts;
+}
+
+void MomentTable::updateRow(const geometrize::Bitmap& target, const geometrize::Bitmap& current, const std::uint32_t y)
+{
+    const std::uint8_t* const t{target.row(y)};
+    const std::uint8_t* const c{current.row(y)};
+    std::uint32_t* const sums{&m_currentSums[static_cast<std::size_t>(y) * (m_width + 1U) * 4U]};
+    std::uint64_t* const squares{&m_currentSquares[static_cast<std::size_t>(y) * (m_width + 1U)]};
+    std::uint64_t* const products{&m_crossProducts[static_cast<std::size_t>(y) * (m_width + 1U)]};
+
+    for(std::size_t x = 0; x < m_width; x++) {
+        std::uint32_t square{0};
+        std::uint32_t product{0};
+        for(std::size_t ch = 0; ch < 4U; ch++) {
+            const std::uint32_t value{c[x * 4U + ch]};
+            sums[(x + 1U) * 4U + ch] = sums[x * 4U + ch] + value;
+            square += value * value;
+            product += value * t[x * 4U + ch];
+        }
+        squares[x + 1U] = squares[x] + square;
+        products[x + 1U] = products[x] + product;
+    }
+}
+
+}
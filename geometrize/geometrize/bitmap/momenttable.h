@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "pixelmoments.h"
+
+namespace geometrize
+{
+class Bitmap;
+class Scanline;
+}
+
+namespace geometrize
+{
+
+/**
+ * @brief The MomentTable class keeps per-row prefix sums of pixel moments for a target and current bitmap pair.
+ * With these the moments under a scanline, and so its color and a closed-form estimate of the error change from blending over it, cost O(1) per scanline instead of O(pixels).
+ * The moments are t and c per channel, plus t^2, c^2 and t*c summed over all channels, where t is a target pixel and c a current pixel.
+ * The target moments are built once, the current moments need updating whenever the current bitmap changes.
+ * @author Sam Twidale (https://samcodes.co.uk/)
+ */
+class MomentTable
+{
+public:
+    /**
+     * @brief MomentTable Creates a new moment table for the given bitmaps.
+     * @param target The target bitmap.
+     * @param current The current bitmap, must be the same size as the target.
+     */
+    MomentTable(const geometrize::Bitmap& target, const geometrize::Bitmap& current);
+
+    ~MomentTable() = default;
+    MomentTable& operator=(const geometrize::MomentTable&) = default;
+    MomentTable(const geometrize::MomentTable&) = default;
+
+    /**
+     * @brief getWidth Gets the width of the bitmaps the table was built for.
+     * @return The width of the bitmaps.
+     */
+    std::uint32_t getWidth() const;
+
+    /**
+     * @brief getHeight Gets the height of the bitmaps the table was built for.
+     * @return The height of the bitmaps.
+     */
+    std::uint32_t getHeight() const;
+
+    /**
+     * @brief update Rebuilds the moments of the current bitmap, e.g. after it was reset or modified externally.
+     * @param target The target bitmap.
+     * @param current The current bitmap.
+     */
+    void update(const geometrize::Bitmap& target, const geometrize::Bitmap& current);
+
+    /**
+     * @brief updateRows Rebuilds the moments of the current bitmap for the rows touched by the given scanlines.
+     * @param target The target bitmap.
+     * @param current The current bitmap.
+     * @param lines The scanlines that were drawn onto the current bitmap.
+     */
+    void updateRows(const geometrize::Bitmap& target, const geometrize::Bitmap& current, const std::vector<geometrize::Scanline>& lines);
+
+    /**
+     * @brief getMoments Gathers the moments of the target and current pixels covered by the scanlines.
+     * @param lines The scanlines.
+     * @return The moments of the covered pixels.
+     */
+    geometrize::PixelMoments getMoments(const std::vector<geometrize::Scanline>& lines) const;
+
+    /**
+     * @brief getSquaredError Gets the total squared error between the target and current pixels covered by a scanline.
+     * @param line The scanline.
+     * @return The sum of (t - c)^2 over every channel of every pixel covered by the scanline.
+     */
+    std::uint64_t getSquaredError(const geometrize::Scanline& line) const;
+
+private:
+    /**
+     * @brief updateRow Rebuilds the current bitmap moments for one row.
+     */
+    void updateRow(const geometrize::Bitmap& target, const geometrize::Bitmap& current, std::uint32_t y);
+
+    std::uint32_t m_width; ///< The width of the bitmaps.
+    std::uint32_t m_height; ///< The height of the bitmaps.
+    std::vector<std::uint32_t> m_targetSums; ///< Per-row prefix sums of the target channels, RGBA interleaved, (width + 1) entries per row.
+    std::vector<std::uint32_t> m_currentSums; ///< Per-row prefix sums of the current channels, RGBA interleaved, (width + 1) entries per row.
+    std::vector<std::uint64_t> m_targetSquares; ///< Per-row prefix sums of t^2 over all channels.
+    std::vector<std::uint64_t> m_currentSquares; ///< Per-row prefix sums of c^2 over all channels.
+    std::vector<std::uint64_t> m_crossProducts; ///< Per-row prefix sums of t*c over all channels.
+};
+
+}
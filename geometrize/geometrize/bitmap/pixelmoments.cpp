@@ -0,0 +1,34 @@
+#include "pixelmoments.h"
+
+#include <cstddef>
+
+#include "rgba.h"
+#include "../simd/kernels.h"
+
+namespace geometrize
+{
+
+double estimateErrorDelta(const geometrize::PixelMoments& moments, const geometrize::rgba color)
+{
+    // drawLines blends each channel as floor((s + c * (255 - alpha) * 257 / 255) / 256) in fixed-point, where s is the premultiplied 16-bit source
+    // Model that as after = A * c + B, with the floor taken as losing half a unit on average for the color channels
+    // The current alpha is usually a constant 255, which the floor maps exactly to 255, so the alpha line is instead pinned to that end
+    // Expanding sum((t - A * c - B)^2 - (t - c)^2) then only needs the moments
+    const geometrize::simd::BlendColor blend(geometrize::simd::makeBlendColor(color));
+    const double a{static_cast<double>(blend.inverseAlpha) * 257.0 / (255.0 * 256.0)};
+    const double b[4]{
+        static_cast<double>(blend.red) / 256.0 - 0.5,
+        static_cast<double>(blend.green) / 256.0 - 0.5,
+        static_cast<double>(blend.blue) / 256.0 - 0.5,
+        255.0 * (1.0 - a)
+    };
+    const double n{static_cast<double>(moments.count)};
+
+    double delta{(2.0 - 2.0 * a) * static_cast<double>(moments.crossProducts) + (a * a - 1.0) * static_cast<double>(moments.currentSquares)};
+    for(std::size_t c = 0; c < 4U; c++) {
+        delta += -2.0 * b[c] * static_cast<double>(moments.target[c]) + 2.0 * a * b[c] * static_cast<double>(moments.current[c]) + n * b[c] * b[c];
+    }
+    return delta;
+}
+
+}
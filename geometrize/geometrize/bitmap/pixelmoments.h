@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+#include "rgba.h"
+
+namespace geometrize
+{
+
+/**
+ * @brief The PixelMoments struct holds the moments of a set of target and current pixels, as gathered by the moment and summed-area tables.
+ * Channels are indexed in RGBA order. t is a target pixel component and c the current pixel component of the same channel.
+ * @author Sam Twidale (https://samcodes.co.uk/)
+ */
+struct PixelMoments
+{
+    std::uint64_t target[4]; ///< Sum of t for each channel.
+    std::uint64_t current[4]; ///< Sum of c for each channel.
+    std::uint64_t targetSquares; ///< Sum of t^2 over all channels.
+    std::uint64_t currentSquares; ///< Sum of c^2 over all channels.
+    std::uint64_t crossProducts; ///< Sum of t*c over all channels.
+    std::uint64_t count; ///< The number of pixels.
+};
+
+/**
+ * @brief estimateErrorDelta Estimates the change in total squared error if the given color were blended over the pixels the moments were gathered from.
+ * This treats the blend as the linear function of the current pixel that drawLines approximates in fixed-point, so it is close but not bit-exact.
+ * @param moments The moments of the pixels.
+ * @param color The color (including alpha) that would be drawn.
+ * @return The estimated change in total squared error, summed over all four channels.
+ */
+double estimateErrorDelta(const geometrize::PixelMoments& moments, geometrize::rgba color);
+
+}
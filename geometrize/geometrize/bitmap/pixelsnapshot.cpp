@@ -0,0 +1,69 @@
+#include "pixelsnapshot.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bitmap.h"
+#include "rgba.h"
+#include "../rasterizer/scanline.h"
+#include "../simd/kernels.h"
+
+namespace geometrize
+{
+
+PixelSnapshot::PixelSnapshot(const geometrize::Bitmap& bitmap, const std::vector<geometrize::Scanline>& lines) : m_lines{lines}
+{
+    std::size_t count{0};
+    for(const geometrize::Scanline& line : m_lines) {
+        if(line.x2 >= line.x1) {
+            assert(line.y >= 0 && static_cast<std::uint32_t>(line.y) < bitmap.getHeight());
+            assert(line.x1 >= 0 && static_cast<std::uint32_t>(line.x2) < bitmap.getWidth());
+            count += static_cast<std::size_t>(line.x2 - line.x1 + 1);
+        }
+    }
+    m_pixels.resize(count * 4U);
+
+    std::uint8_t* saved{m_pixels.data()};
+    for(const geometrize::Scanline& line : m_lines) {
+        if(line.x2 < line.x1) {
+            continue;
+        }
+        const std::uint8_t* row{bitmap.row(static_cast<std::uint32_t>(line.y))};
+        saved = std::copy(row + static_cast<std::size_t>(line.x1) * 4U, row + (static_cast<std::size_t>(line.x2) + 1U) * 4U, saved);
+    }
+}
+
+std::int64_t PixelSnapshot::getErrorDelta(const geometrize::Bitmap& target, const geometrize::Bitmap& after) const
+{
+    std::int64_t delta{0};
+    const std::uint8_t* saved{m_pixels.data()};
+    for(const geometrize::Scanline& line : m_lines) {
+        if(line.x2 < line.x1) {
+            continue;
+        }
+        const std::uint32_t y{static_cast<std::uint32_t>(line.y)};
+        const std::size_t offset{static_cast<std::size_t>(line.x1) * 4U};
+        const std::size_t length{static_cast<std::size_t>(line.x2 - line.x1 + 1)};
+        delta += geometrize::simd::squaredErrorDelta(target.row(y) + offset, saved, after.row(y) + offset, length);
+        saved += length * 4U;
+    }
+    return delta;
+}
+
+void PixelSnapshot::restore(geometrize::Bitmap& bitmap) const
+{
+    const std::uint8_t* saved{m_pixels.data()};
+    for(const geometrize::Scanline& line : m_lines) {
+        if(line.x2 < line.x1) {
+            continue;
+        }
+        const std::size_t length{static_cast<std::size_t>(line.x2 - line.x1 + 1) * 4U};
+        std::copy(saved, saved + length, bitmap.row(static_cast<std::uint32_t>(line.y)) + static_cast<std::size_t>(line.x1) * 4U);
+        saved += length;
+    }
+}
+
+}
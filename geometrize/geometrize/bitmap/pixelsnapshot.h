@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../rasterizer/scanline.h"
+
+namespace geometrize
+{
+class Bitmap;
+}
+
+namespace geometrize
+{
+
+/**
+ * @brief The PixelSnapshot class saves the pixels of a bitmap covered by a set of scanlines, so that drawing over them can be measured and undone
+ * without copying the whole bitmap. Memory use and the cost of each operation scale with the area of the scanlines, not the size of the bitmap.
+ * @author Sam Twidale (https://samcodes.co.uk/)
+ */
+class PixelSnapshot
+{
+public:
+    /**
+     * @brief PixelSnapshot Saves the pixels of the bitmap covered by the scanlines.
+     * @param bitmap The bitmap to save the pixels of.
+     * @param lines The scanlines covering the pixels to save, these must lie within the bitmap.
+     */
+    PixelSnapshot(const geometrize::Bitmap& bitmap, const std::vector<geometrize::Scanline>& lines);
+
+    ~PixelSnapshot() = default;
+    PixelSnapshot& operator=(const geometrize::PixelSnapshot&) = default;
+    PixelSnapshot(const geometrize::PixelSnapshot&) = default;
+
+    /**
+     * @brief getErrorDelta Calculates the change in total squared error between the target and the bitmap since the snapshot was taken.
+     * Gives the same result as core::differencePartial would with a full copy of the bitmap as it was when the snapshot was taken.
+     * @param target The target bitmap.
+     * @param after The bitmap the snapshot was taken of, after drawing over the saved pixels.
+     * @return The change in total squared error over the saved pixels, negative if the bitmap got closer to the target.
+     */
+    std::int64_t getErrorDelta(const geometrize::Bitmap& target, const geometrize::Bitmap& after) const;
+
+    /**
+     * @brief restore Writes the saved pixels back to the bitmap.
+     * @param bitmap The bitmap the snapshot was taken of.
+     */
+    void restore(geometrize::Bitmap& bitmap) const;
+
+private:
+    std::vector<geometrize::Scanline> m_lines; ///< The scanlines covering the saved pixels.
+    std::vector<std::uint8_t> m_pixels; ///< The saved pixels, RGBA8888, in scanline order.
+};
+
+}
@@ -0,0 +1,144 @@
+#include "summedareatable.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bitmap.h"
+#include "pixelmoments.h"
+#include "../rasterizer/scanline.h"
+
+namespace geometrize
+{
+
+SummedAreaTable::SummedAreaTable(const geometrize::Bitmap& target, const geometrize::Bitmap& current) :
+    m_width{target.getWidth()},
+    m_height{target.getHeight()},
+    m_targetSums((target.getWidth() + 1U) * (target.getHeight() + 1U) * 4U),
+    m_currentSums(m_targetSums.size()),
+    m_targetSquares((target.getWidth() + 1U) * (target.getHeight() + 1U)),
+    m_currentSquares(m_targetSquares.size()),
+    m_crossProducts(m_targetSquares.size())
+{
+    assert(target.getWidth() == current.getWidth());
+    assert(target.getHeight() == current.getHeight());
+    assert(static_cast<std::uint64_t>(m_width) * m_height < UINT32_MAX / 255U && "Image too large for 32-bit summed-area tables");
+
+    const std::size_t stride{(m_width + 1U) * 4U};
+    for(std::uint32_t y = 0; y < m_height; y++) {
+        const std::uint8_t* row{target.row(y)};
+        const std::uint32_t* above{&m_targetSums[static_cast<std::size_t>(y) * stride]};
+        std::uint32_t* sums{&m_targetSums[static_cast<std::size_t>(y + 1U) * stride]};
+        const std::uint64_t* squaresAbove{&m_targetSquares[static_cast<std::size_t>(y) * (m_width + 1U)]};
+        std::uint64_t* squares{&m_targetSquares[static_cast<std::size_t>(y + 1U) * (m_width + 1U)]};
+        std::uint32_t run[4]{0, 0, 0, 0};
+        std::uint64_t squaresRun{0};
+        for(std::size_t x = 0; x < m_width; x++) {
+            for(std::size_t c = 0; c < 4U; c++) {
+                const std::uint32_t value{row[x * 4U + c]};
+                run[c] += value;
+                squaresRun += value * value;
+                sums[(x + 1U) * 4U + c] = above[(x + 1U) * 4U + c] + run[c];
+            }
+            squares[x + 1U] = squaresAbove[x + 1U] + squaresRun;
+        }
+    }
+
+    update(target, current);
+}
+
+std::uint32_t SummedAreaTable::getWidth() const
+{
+    return m_width;
+}
+
+std::uint32_t SummedAreaTable::getHeight() const
+{
+    return m_height;
+}
+
+void SummedAreaTable::update(const geometrize::Bitmap& target, const geometrize::Bitmap& current)
+{
+    refresh(target, current, 0, 0);
+}
+
+void SummedAreaTable::updateRegion(const geometrize::Bitmap& target, const geometrize::Bitmap& current, const std::vector<geometrize::Scanline>& lines)
+{
+    std::int32_t left{static_cast<std::int32_t>(m_width)};
+    std::int32_t top{static_cast<std::int32_t>(m_height)};
+    for(const geometrize::Scanline& line : lines) {
+        if(line.x2 < line.x1) {
+            continue;
+        }
+        left = std::min(left, line.x1);
+        top = std::min(top, line.y);
+    }
+    if(left >= static_cast<std::int32_t>(m_width) || top >= static_cast<std::int32_t>(m_height)) {
+        return;
+    }
+    refresh(target, current, static_cast<std::uint32_t>(std::max(left, 0)), static_cast<std::uint32_t>(std::max(top, 0)));
+}
+
+geometrize::PixelMoments SummedAreaTable::getMoments(const std::int32_t x1, const std::int32_t y1, const std::int32_t x2, const std::int32_t y2) const
+{
+    geometrize::PixelMoments moments{{0, 0, 0, 0}, {0, 0, 0, 0}, 0, 0, 0, 0};
+    if(x2 < x1 || y2 < y1) {
+        return moments;
+    }
+
+    const std::size_t stride{m_width + 1U};
+    const std::size_t topLeft{static_cast<std::size_t>(y1) * stride + static_cast<std::size_t>(x1)};
+    const std::size_t topRight{static_cast<std::size_t>(y1) * stride + static_cast<std::size_t>(x2 + 1)};
+    const std::size_t bottomLeft{static_cast<std::size_t>(y2 + 1) * stride + static_cast<std::size_t>(x1)};
+    const std::size_t bottomRight{static_cast<std::size_t>(y2 + 1) * stride + static_cast<std::size_t>(x2 + 1)};
+
+    for(std::size_t c = 0; c < 4U; c++) {
+        moments.target[c] = static_cast<std::uint32_t>(m_targetSums[bottomRight * 4U + c] - m_targetSums[bottomLeft * 4U + c] - m_targetSums[topRight * 4U + c] + m_targetSums[topLeft * 4U + c]);
+        moments.current[c] = static_cast<std::uint32_t>(m_currentSums[bottomRight * 4U + c] - m_currentSums[bottomLeft * 4U + c] - m_currentSums[topRight * 4U + c] + m_currentSums[topLeft * 4U + c]);
+    }
+    moments.targetSquares = m_targetSquares[bottomRight] - m_targetSquares[bottomLeft] - m_targetSquares[topRight] + m_targetSquares[topLeft];
+    moments.currentSquares = m_currentSquares[bottomRight] - m_currentSquares[bottomLeft] - m_currentSquares[topRight] + m_currentSquares[topLeft];
+    moments.crossProducts = m_crossProducts[bottomRight] - m_crossProducts[bottomLeft] - m_crossProducts[topRight] + m_crossProducts[topLeft];
+    moments.count = static_cast<std::uint64_t>(x2 - x1 + 1) * static_cast<std::uint64_t>(y2 - y1 + 1);
+    return moments;
+}
+
+void SummedAreaTable::refresh(const geometrize::Bitmap& target, const geometrize::Bitmap& current, const std::uint32_t x, const std::uint32_t y)
+{
+    const std::size_t stride{m_width + 1U};
+
+    for(std::size_t row = y; row < m_height; row++) {
+        const std::uint8_t* const t{target.row(static_cast<std::uint32_t>(row))};
+        const std::uint8_t* const c{current.row(static_cast<std::uint32_t>(row))};
+        const std::size_t above{row * stride};
+        const std::size_t below{(row + 1U) * stride};
+
+        // Entries left of x are unchanged, so the running row sums start from the difference of the column x entries
+        std::uint32_t sums[4];
+        for(std::size_t ch = 0; ch < 4U; ch++) {
+            sums[ch] = m_currentSums[(below + x) * 4U + ch] - m_currentSums[(above + x) * 4U + ch];
+        }
+        std::uint64_t squares{m_currentSquares[below + x] - m_currentSquares[above + x]};
+        std::uint64_t products{m_crossProducts[below + x] - m_crossProducts[above + x]};
+
+        for(std::size_t col = x; col < m_width; col++) {
+            std::uint32_t square{0};
+            std::uint32_t product{0};
+            for(std::size_t ch = 0; ch < 4U; ch++) {
+                const std::uint32_t value{c[col * 4U + ch]};
+                sums[ch] += value;
+                square += value * value;
+                product += value * t[col * 4U + ch];
+                m_currentSums[(below + col + 1U) * 4U + ch] = m_currentSums[(above + col + 1U) * 4U + ch] + sums[ch];
+            }
+            squares += square;
+            products += product;
+            m_currentSquares[below + col + 1U] = m_currentSquares[above + col + 1U] + squares;
+            m_crossProducts[below + col + 1U] = m_crossProducts[above + col + 1U] + products;
+        }
+    }
+}
+
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "pixelmoments.h"
+
+namespace geometrize
+{
+class Bitmap;
+class Scanline;
+}
+
+namespace geometrize
+{
+
+/**
+ * @brief The SummedAreaTable class keeps 2D summed-area tables of pixel moments for a target and current bitmap pair.
+ * The moments of any axis-aligned rectangle of pixels then take four lookups each, whatever the size of the rectangle.
+ * It stores the same moments as geometrize::MomentTable. An entry depends on every pixel above and to the left of it, so changing a pixel
+ * means refreshing the entries below and to the right of it.
+ * @author Sam Twidale (https://samcodes.co.uk/)
+ */
+class SummedAreaTable
+{
+public:
+    /**
+     * @brief SummedAreaTable Creates a new summed-area table for the given bitmaps.
+     * @param target The target bitmap.
+     * @param current The current bitmap, must be the same size as the target.
+     */
+    SummedAreaTable(const geometrize::Bitmap& target, const geometrize::Bitmap& current);
+
+    ~SummedAreaTable() = default;
+    SummedAreaTable& operator=(const geometrize::SummedAreaTable&) = default;
+    SummedAreaTable(const geometrize::SummedAreaTable&) = default;
+
+    /**
+     * @brief getWidth Gets the width of the bitmaps the table was built for.
+     * @return The width of the bitmaps.
+     */
+    std::uint32_t getWidth() const;
+
+    /**
+     * @brief getHeight Gets the height of the bitmaps the table was built for.
+     * @return The height of the bitmaps.
+     */
+    std::uint32_t getHeight() const;
+
+    /**
+     * @brief update Rebuilds the moments of the current bitmap, e.g. after it was reset or modified externally.
+     * @param target The target bitmap.
+     * @param current The current bitmap.
+     */
+    void update(const geometrize::Bitmap& target, const geometrize::Bitmap& current);
+
+    /**
+     * @brief updateRegion Refreshes the moments of the current bitmap after the given scanlines were drawn onto it.
+     * Only the entries at or below and right of the top-left corner of the scanlines' bounding box are touched.
+     * @param target The target bitmap.
+     * @param current The current bitmap.
+     * @param lines The scanlines that were drawn onto the current bitmap.
+     */
+    void updateRegion(const geometrize::Bitmap& target, const geometrize::Bitmap& current, const std::vector<geometrize::Scanline>& lines);
+
+    /**
+     * @brief getMoments Gathers the moments of the target and current pixels in a rectangle.
+     * @param x1 The left edge of the rectangle (inclusive).
+     * @param y1 The top edge of the rectangle (inclusive).
+     * @param x2 The right edge of the rectangle (inclusive).
+     * @param y2 The bottom edge of the rectangle (inclusive).
+     * @return The moments of the pixels in the rectangle.
+     */
+    geometrize::PixelMoments getMoments(std::int32_t x1, std::int32_t y1, std::int32_t x2, std::int32_t y2) const;
+
+private:
+    /**
+     * @brief refresh Recomputes the current bitmap moments for every entry right of x and below y.
+     */
+    void refresh(const geometrize::Bitmap& target, const geometrize::Bitmap& current, std::uint32_t x, std::uint32_t y);
+
+    std::uint32_t m_width; ///< The width of the bitmaps.
+    std::uint32_t m_height; ///< The height of the bitmaps.
+
+    // The tables have (width + 1) * (height + 1) entries, entry (x, y) holding the sum over the pixels above and left of (x, y)
+    // The linear sums are kept modulo 2^32, which is exact for the difference of any four entries as long as the image has fewer than 2^32 / 255 pixels
+    std::vector<std::uint32_t> m_targetSums; ///< Sums of the target channels, RGBA interleaved.
+    std::vector<std::uint32_t> m_currentSums; ///< Sums of the current channels, RGBA interleaved.
+    std::vector<std::uint64_t> m_targetSquares; ///< Sums of t^2 over all channels.
+    std::vector<std::uint64_t> m_currentSquares; ///< Sums of c^2 over all channels.
+    std::vector<std::uint64_t> m_crossProducts; ///< Sums of t*c over all channels.
+};
+
+}
@@ -1,8 +1,10 @@
 #include "commonutil.h"
 
 #include <assert.h>
+#include <cstddef>
 #include <cstdint>
 #include <random>
+#include <vector>
 
 #include "bitmap/bitmap.h"
 #include "bitmap/rgba.h"
@@ -21,6 +23,19 @@ void seedRandomGenerator(const std::uint32_t seed)
     mt.seed(seed);
 }
 
+void seedRandomGenerator(const std::uint32_t seed, const std::uint32_t step, const std::uint32_t index)
+{
+    // Hash the counter with splitmix64 finalizers so nearby counters give unrelated streams
+    const auto mix = [](std::uint64_t z) {
+        z += 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    };
+    const std::uint64_t key{mix(mix(mix(seed) ^ step) ^ index)};
+    mt.seed(static_cast<std::uint32_t>(key ^ (key >> 32)));
+}
+
 std::int32_t randomRange(const std::int32_t min, const std::int32_t max)
 {
     assert(min <= max);
@@ -29,21 +44,23 @@ std::int32_t randomRange(const std::int32_t min, const std::int32_t max)
 
 geometrize::rgba getAverageImageColor(const geometrize::Bitmap& image)
 {
-    const std::vector<std::uint8_t>& data{image.getDataRef()};
-    const std::size_t size{data.size()};
-    if(size == 0) {
+    const std::size_t width{image.getWidth()};
+    const std::uint32_t height{image.getHeight()};
+    const std::size_t numPixels{width * height};
+    if(numPixels == 0) {
         return geometrize::rgba{0, 0, 0, 0};
     }
 
-    const std::size_t numPixels{size / 4U};
-
     std::uint32_t totalRed{0};
     std::uint32_t totalGreen{0};
     std::uint32_t totalBlue{0};
-    for(std::size_t i = 0; i < size; i += 4U) {
-        totalRed += data[i];
-        totalGreen += data[i + 1U];
-        totalBlue += data[i + 2U];
+    for(std::uint32_t y = 0; y < height; y++) {
+        const std::uint8_t* const data{image.row(y)};
+        for(std::size_t i = 0; i < width * 4U; i += 4U) {
+            totalRed += data[i];
+            totalGreen += data[i + 1U];
+            totalBlue += data[i + 2U];
+        }
     }
 
     return geometrize::rgba{
@@ -54,6 +71,37 @@ geometrize::rgba getAverageImageColor(const geometrize::Bitmap& image)
     };
 }
 
+geometrize::Bitmap downsampleImage(const geometrize::Bitmap& image, const std::uint32_t factor)
+{
+    assert(factor > 0);
+    const std::uint32_t width{image.getWidth()};
+    const std::uint32_t height{image.getHeight()};
+    const std::uint32_t smallWidth{(width + factor - 1U) / factor};
+    const std::uint32_t smallHeight{(height + factor - 1U) / factor};
+
+    std::vector<std::uint8_t> smallData(static_cast<std::size_t>(smallWidth) * smallHeight * 4U);
+    for(std::uint32_t sy = 0; sy < smallHeight; sy++) {
+        for(std::uint32_t sx = 0; sx < smallWidth; sx++) {
+            std::uint32_t totals[4]{0, 0, 0, 0};
+            std::uint32_t count{0};
+            for(std::uint32_t y = sy * factor; y < height && y < (sy + 1U) * factor; y++) {
+                const std::uint8_t* const data{image.row(y)};
+                for(std::uint32_t x = sx * factor; x < width && x < (sx + 1U) * factor; x++) {
+                    for(std::size_t c = 0; c < 4U; c++) {
+                        totals[c] += data[x * 4U + c];
+                    }
+                    count++;
+                }
+            }
+            const std::size_t offset{(static_cast<std::size_t>(sy) * smallWidth + sx) * 4U};
+            for(std::size_t c = 0; c < 4U; c++) {
+                smallData[offset + c] = static_cast<std::uint8_t>((totals[c] + count / 2U) / count);
+            }
+        }
+    }
+    return geometrize::Bitmap(smallWidth, smallHeight, smallData);
+}
+
 }
 
 }
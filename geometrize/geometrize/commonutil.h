@@ -22,6 +22,15 @@ namespace commonutil
  */
 void seedRandomGenerator(std::uint32_t seed);
 
+/**
+ * @brief seedRandomGenerator Seeds the (thread-local) random number generators with the stream identified by a counter.
+ * The stream depends only on the three values, not on the thread or on what was generated before, so work can be split between any number of threads reproducibly.
+ * @param seed The random seed.
+ * @param step The index of the model step the numbers are for.
+ * @param index The index of the candidate (or other unit of work) within the step.
+ */
+void seedRandomGenerator(std::uint32_t seed, std::uint32_t step, std::uint32_t index);
+
 /**
  * @brief randomRange Returns a random integer in the range, inclusive. Uses thread-local random number generators under the hood.
  * To ensure deterministic shape generation that can be repeated for different seeds, this should be used for shape mutation, but nothing else.
@@ -50,6 +59,14 @@ template<typename T> T clamp(const T& value, const T& lower, const T& upper)
  */
 geometrize::rgba getAverageImageColor(const geometrize::Bitmap& image);
 
+/**
+ * @brief downsampleImage Shrinks an image by an integer factor, each pixel of the result being the average of a square block of pixels of the image.
+ * @param image The image to shrink.
+ * @param factor The factor to shrink by, must be greater than zero. Blocks at the right and bottom edges are cropped where the size isn't a multiple of the factor.
+ * @return The shrunk image, ceil(width / factor) by ceil(height / factor) pixels.
+ */
+geometrize::Bitmap downsampleImage(const geometrize::Bitmap& image, std::uint32_t factor);
+
 }
 
 }
@@ -1,102 +1,654 @@
 #include "core.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "bitmap/bitmap.h"
+#include "bitmap/lowresolutionproxy.h"
+#include "bitmap/momenttable.h"
+#include "bitmap/pixelmoments.h"
 #include "bitmap/rgba.h"
+#include "bitmap/summedareatable.h"
 #include "commonutil.h"
 #include "rasterizer/rasterizer.h"
 #include "rasterizer/scanline.h"
+#include "rasterizer/spanrasterizer.h"
 #include "shape/shape.h"
+#include "shape/shapefactory.h"
+#include "shape/shapespace.h"
+#include "shape/shapevariant.h"
+#include "simd/kernels.h"
 #include "state.h"
 
 namespace
 {
 
 /**
-* @brief hillClimb Hill climbing optimization algorithm, attempts to minimize energy (the error/difference).
-* @param state The state to optimize.
+ * @brief The DefaultEnergy struct calls the default energy function directly. The searches below are templates on their energy function,
+ * so when no custom energy function is given they are instantiated with this and the energy calls can be inlined, rather than going through a std::function.
+ */
+struct DefaultEnergy
+{
+    geometrize::core::Energy operator()(
+            const std::vector<geometrize::Scanline>& lines,
+            const std::uint32_t alpha,
+            const geometrize::Bitmap& target,
+            const geometrize::Bitmap& current,
+            geometrize::Bitmap& buffer,
+            const std::int64_t bound) const
+    {
+        return geometrize::core::defaultEnergyFunction(lines, alpha, target, current, buffer, bound);
+    }
+};
+
+/**
+ * @brief createCandidateShape Creates a shape for a search in an existing variant. Built-in shapes reuse the storage of the shape the variant held,
+ * so a search can create all of its candidates in a few variants without allocating.
+ * @param shapeCreator The function to create the shape with, or null to create one of the built-in shapes of the space.
+ * @param space The space the search is over.
+ * @param shape The variant to hold the new shape.
+ */
+void createCandidateShape(const std::function<geometrize::ShapeVariant(void)>& shapeCreator, const geometrize::ShapeSpace& space, geometrize::ShapeVariant& shape)
+{
+    if(shapeCreator) {
+        shape = shapeCreator();
+    } else {
+        geometrize::createShape(space, shape);
+    }
+}
+
+/**
+ * @brief keepState Adds a state to a list of the best few states, kept sorted by score with ties going to the earlier state.
+ * Once the list is full the state must beat the worst in the list, which it replaces. It is swapped in, so the state is left holding the replaced one
+ * and the storage of the shapes is passed around rather than reallocated.
+ * @param states The best states so far.
+ * @param count The number of states to keep.
+ * @param state The state to add.
+ */
+void keepState(std::vector<geometrize::core::Candidate>& states, const std::uint32_t count, geometrize::core::Candidate& state)
+{
+    if(states.size() < count) {
+        states.push_back(state);
+    } else {
+        assert(state.score < states.back().score);
+        std::swap(states.back(), state);
+    }
+    const auto last = states.end() - 1;
+    const auto it = std::upper_bound(states.begin(), last, *last, [](const geometrize::core::Candidate& a, const geometrize::core::Candidate& b) {
+        return a.score < b.score;
+    });
+    std::rotate(it, last, states.end());
+}
+
+/**
+ * @brief mutateShape Mutates the shape held by a variant, which must be a ShapeT. Specialized for geometrize::ShapeVariant to mutate any shape, including custom ones.
+ */
+template<typename ShapeT>
+void mutateShape(geometrize::ShapeVariant& shape, const geometrize::ShapeSpace& space)
+{
+    geometrize::mutateInSpace(static_cast<ShapeT&>(shape.get()), space);
+}
+
+template<>
+void mutateShape<geometrize::ShapeVariant>(geometrize::ShapeVariant& shape, const geometrize::ShapeSpace& space)
+{
+    geometrize::mutate(shape, space);
+}
+
+/**
+ * @brief getShape Gets the shape held by a variant as a ShapeT, which it must be. Specialized for geometrize::ShapeVariant to get the variant itself.
+ */
+template<typename ShapeT>
+const ShapeT& getShape(const geometrize::ShapeVariant& shape)
+{
+    return static_cast<const ShapeT&>(shape.get());
+}
+
+template<>
+const geometrize::ShapeVariant& getShape<geometrize::ShapeVariant>(const geometrize::ShapeVariant& shape)
+{
+    return shape;
+}
+
+/**
+ * @brief scoreShape Scores a shape, by rasterizing it and passing the scanlines to the energy function.
+ * The scanlines go in a buffer kept by each thread, so once it has grown to fit the shapes being searched, scoring them allocates nothing.
+ * @param s The shape.
+ * @param space The space the shape was created in.
+ * @param alpha The alpha of the shape.
+ * @param target The target bitmap.
+ * @param current The current bitmap.
+ * @param buffer The buffer bitmap.
+ * @param bound The bound to pass to the energy function.
+ * @param energyFunction The energy function.
+ * @return The energy of the shape.
+ */
+template<typename ShapeT, typename EnergyT>
+geometrize::core::Energy scoreShape(
+        const ShapeT& s,
+        const geometrize::ShapeSpace& space,
+        const std::uint32_t alpha,
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& current,
+        geometrize::Bitmap& buffer,
+        const std::int64_t bound,
+        const EnergyT& energyFunction)
+{
+    thread_local std::vector<geometrize::Scanline> lines;
+    geometrize::rasterizeInSpace(s, space, lines);
+    return energyFunction(lines, alpha, target, current, buffer, bound);
+}
+
+/**
+ * @brief scoreSpans Scores a shape with a push-style rasterizer with the default energy function, without making a vector of its scanlines.
+ * The spans are made twice rather than stored: first to sum the colors under the shape, then to measure the change in error blending the shape's color
+ * over them would make. This comes out the same as fusedEnergyFunction, and so as defaultEnergyFunction.
+ * Given a bound, the first pass also gets the current error of each span, and the second stops measuring once the bound is out of reach, as in fusedEnergyFunction.
+ * @param s The shape.
+ * @param space The space the shape was created in.
+ * @param alpha The alpha of the shape.
+ * @param target The target bitmap.
+ * @param current The current bitmap.
+ * @param bound The energy to beat.
+ * @return The energy of the shape.
+ */
+template<typename ShapeT>
+geometrize::core::Energy scoreSpans(
+        const ShapeT& s,
+        const geometrize::ShapeSpace& space,
+        const std::uint32_t alpha,
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& current,
+        const std::int64_t bound)
+{
+    // Visits the spans of the shape clipped to the space, as rasterizeInSpace would give them
+    const auto forEachSpanInSpace = [&s, &space](auto visit) {
+        geometrize::forEachSpan(s, space.xMax, space.yMax, [&space, &visit](const std::int32_t y, const std::int32_t x1, const std::int32_t x2) {
+            if(y >= space.yMin && x2 >= space.xMin) {
+                visit(y, (std::max)(x1, space.xMin), x2);
+            }
+        });
+    };
+
+    // The best case of each span in the order they are made, the spans can't be reordered so they are visited in the same order in the second pass
+    const bool bounded{bound != geometrize::core::noEnergyBound};
+    thread_local std::vector<std::int64_t> bestCases;
+    bestCases.clear();
+    std::int64_t bestCaseRemaining{0};
+
+    geometrize::simd::ColorSums sums{0, 0, 0, 0, 0, 0};
+    std::int64_t count{0};
+    forEachSpanInSpace([&](const std::int32_t y, const std::int32_t x1, const std::int32_t x2) {
+        const std::uint32_t row{static_cast<std::uint32_t>(y)};
+        const std::size_t offset{static_cast<std::size_t>(x1) * 4U};
+        const std::size_t length{static_cast<std::size_t>(x2 - x1 + 1)};
+        geometrize::simd::accumulateColorSums(target.row(row) + offset, current.row(row) + offset, length, sums);
+        if(bounded) {
+            bestCases.push_back(-geometrize::simd::squaredError(target.row(row) + offset, current.row(row) + offset, length));
+            bestCaseRemaining += bestCases.back();
+        }
+        count += static_cast<std::int64_t>(length);
+    });
+    if(bounded && bestCaseRemaining >= bound) {
+        return geometrize::core::Energy{bestCaseRemaining, false};
+    }
+
+    const geometrize::rgba color(geometrize::core::computeColor(sums, count, static_cast<std::uint8_t>(alpha)));
+    const geometrize::simd::BlendColor blendColor(geometrize::simd::makeBlendColor(color));
+    std::int64_t delta{0};
+    std::size_t span{0};
+    bool stopped{false};
+    forEachSpanInSpace([&](const std::int32_t y, const std::int32_t x1, const std::int32_t x2) {
+        if(stopped) {
+            return; // The rasterizer can't be stopped, but the spans it has left needn't be measured
+        }
+        const std::uint32_t row{static_cast<std::uint32_t>(y)};
+        const std::size_t offset{static_cast<std::size_t>(x1) * 4U};
+        const std::size_t length{static_cast<std::size_t>(x2 - x1 + 1)};
+        delta += geometrize::simd::blendedErrorDelta(target.row(row) + offset, current.row(row) + offset, length, blendColor);
+        if(bounded) {
+            bestCaseRemaining -= bestCases[span++];
+            stopped = delta + bestCaseRemaining >= bound;
+        }
+    });
+    return stopped ? geometrize::core::Energy{delta + bestCaseRemaining, false} : geometrize::core::Energy{delta, true};
+}
+
+/**
+ * Overloads that score the shapes with push-style rasterizers with scoreSpans when the energy function is the default.
+ */
+geometrize::core::Energy scoreShape(const geometrize::Circle& s, const geometrize::ShapeSpace& space, const std::uint32_t alpha,
+        const geometrize::Bitmap& target, const geometrize::Bitmap& current, geometrize::Bitmap&, const std::int64_t bound, const DefaultEnergy&)
+{
+    return scoreSpans(s, space, alpha, target, current, bound);
+}
+
+geometrize::core::Energy scoreShape(const geometrize::Ellipse& s, const geometrize::ShapeSpace& space, const std::uint32_t alpha,
+        const geometrize::Bitmap& target, const geometrize::Bitmap& current, geometrize::Bitmap&, const std::int64_t bound, const DefaultEnergy&)
+{
+    return scoreSpans(s, space, alpha, target, current, bound);
+}
+
+geometrize::core::Energy scoreShape(const geometrize::Rectangle& s, const geometrize::ShapeSpace& space, const std::uint32_t alpha,
+        const geometrize::Bitmap& target, const geometrize::Bitmap& current, geometrize::Bitmap&, const std::int64_t bound, const DefaultEnergy&)
+{
+    return scoreSpans(s, space, alpha, target, current, bound);
+}
+
+geometrize::core::Energy scoreShape(const geometrize::RotatedEllipse& s, const geometrize::ShapeSpace& space, const std::uint32_t alpha,
+        const geometrize::Bitmap& target, const geometrize::Bitmap& current, geometrize::Bitmap&, const std::int64_t bound, const DefaultEnergy&)
+{
+    return scoreSpans(s, space, alpha, target, current, bound);
+}
+
+/**
+ * @brief scoreShape Scores the shape held by a variant, with the overload for the type of the shape. Custom shapes are scored with their own rasterize function.
+ */
+template<typename EnergyT>
+geometrize::core::Energy scoreShape(
+        const geometrize::ShapeVariant& shape,
+        const geometrize::ShapeSpace& space,
+        const std::uint32_t alpha,
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& current,
+        geometrize::Bitmap& buffer,
+        const std::int64_t bound,
+        const EnergyT& energyFunction)
+{
+    if(shape.isCustom()) {
+        return energyFunction(geometrize::rasterize(shape, space), alpha, target, current, buffer, bound);
+    }
+
+    geometrize::core::Energy energy{0, false};
+    geometrize::dispatchShapeType(shape.getType(), [&](auto* tag) {
+        using T = typename std::remove_pointer<decltype(tag)>::type;
+        energy = scoreShape(static_cast<const T&>(shape.get()), space, alpha, target, current, buffer, bound, energyFunction);
+    });
+    return energy;
+}
+
+/**
+* @brief hillClimbShape Hill climbing optimization algorithm, attempts to minimize energy (the error/difference).
+* Instantiated for each built-in shape class, so the mutator and rasterizer of the shape are called directly, and for geometrize::ShapeVariant for custom shapes.
+* @param state The state to optimize, its shape must be a ShapeT.
+* @param space The space the shape was created in.
 * @param maxAge The maximum age.
 * @param target The target bitmap.
 * @param current The current bitmap.
 * @param buffer The buffer bitmap.
-* @param lastScore The last score.
+* @param energyFunction The energy function.
 * @return The best state found from hillclimbing.
 */
-geometrize::State hillClimb(
-        const geometrize::State& state,
+template<typename ShapeT, typename EnergyT>
+geometrize::core::Candidate hillClimbShape(
+        const geometrize::core::Candidate& state,
+        const geometrize::ShapeSpace& space,
         const std::uint32_t maxAge,
         const geometrize::Bitmap& target,
         const geometrize::Bitmap& current,
         geometrize::Bitmap& buffer,
-        const double lastScore,
-        const geometrize::core::EnergyFunction& energyFunction)
+        const EnergyT& energyFunction)
 {
-    geometrize::State s(state);
-    geometrize::State bestState(state);
-    double bestEnergy{bestState.m_score};
+    // The state is always the best found so far: each mutation is made in place, and undone if it doesn't improve on it
+    // Built-in shapes are undone from a snapshot of their parameters, custom shapes from a copy of the whole shape
+    geometrize::core::Candidate s(state);
+    geometrize::ShapeParameters parameters;
+    geometrize::ShapeVariant undo;
 
     std::uint32_t age{0};
     while(age < maxAge) {
-        const geometrize::State undo{s.mutate()};
-        s.m_score = energyFunction(s.m_shape->rasterize(*s.m_shape), s.m_alpha, target, current, buffer, lastScore);
-        const double energy = s.m_score;
-        if(energy >= bestEnergy) {
-            s = undo;
+        const bool saved{s.shape.saveParameters(parameters)};
+        if(!saved) {
+            undo = s.shape;
+        }
+        mutateShape<ShapeT>(s.shape, space);
+        const geometrize::core::Energy energy{scoreShape(getShape<ShapeT>(s.shape), space, s.alpha, target, current, buffer, s.score, energyFunction)};
+        if(!energy.finished || energy.value >= s.score) {
+            if(saved) {
+                s.shape.restoreParameters(parameters);
+            } else {
+                s.shape = undo;
+            }
         } else {
-            bestEnergy = energy;
-            bestState = s;
+            s.score = energy.value;
             age = -1;
         }
         age++;
     }
 
-    return bestState;
+    return s;
+}
+
+/**
+* @brief hillClimb Hill climbs a state with the instance of hillClimbShape for the type of its shape.
+* @param state The state to optimize.
+* @param space The space the shape was created in.
+* @param maxAge The maximum age.
+* @param target The target bitmap.
+* @param current The current bitmap.
+* @param buffer The buffer bitmap.
+* @param energyFunction The energy function.
+* @return The best state found from hillclimbing.
+*/
+template<typename EnergyT>
+geometrize::core::Candidate hillClimb(
+        const geometrize::core::Candidate& state,
+        const geometrize::ShapeSpace& space,
+        const std::uint32_t maxAge,
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& current,
+        geometrize::Bitmap& buffer,
+        const EnergyT& energyFunction)
+{
+    if(state.shape.isCustom()) {
+        return hillClimbShape<geometrize::ShapeVariant>(state, space, maxAge, target, current, buffer, energyFunction);
+    }
+
+    geometrize::core::Candidate result;
+    geometrize::dispatchShapeType(state.shape.getType(), [&](auto* tag) {
+        using T = typename std::remove_pointer<decltype(tag)>::type;
+        result = hillClimbShape<T>(state, space, maxAge, target, current, buffer, energyFunction);
+    });
+    return result;
 }
 
 /**
 * @brief bestRandomState Gets the best state using a random algorithm.
-* @param shapeCreator A function that will create the shapes that will be chosen from.
+* @param shapeCreator A function that will create the shapes that will be chosen from, or null to create the built-in shapes of the space.
+* @param space The space the shapes are created in.
 * @param alpha The opacity of the shape.
 * @param n The number of states to try.
 * @param target The target bitmap.
 * @param current The current bitmap.
 * @param buffer The buffer bitmap.
-* @param lastScore The last score.
+* @param energyFunction The energy function.
 * @return The best random state i.e. the one with the lowest energy.
 */
-geometrize::State bestRandomState(
-        const std::function<std::shared_ptr<geometrize::Shape>(void)>& shapeCreator,
+template<typename EnergyT>
+geometrize::core::Candidate bestRandomState(
+        const std::function<geometrize::ShapeVariant(void)>& shapeCreator,
+        const geometrize::ShapeSpace& space,
         const std::uint32_t alpha,
         const std::uint32_t n,
         const geometrize::Bitmap& target,
         const geometrize::Bitmap& current,
         geometrize::Bitmap& buffer,
-        const double lastScore,
-        const geometrize::core::EnergyFunction& energyFunction)
+        const EnergyT& energyFunction)
 {
-    geometrize::State bestState(shapeCreator(), alpha);
-    bestState.m_score = energyFunction(bestState.m_shape->rasterize(*bestState.m_shape), bestState.m_alpha, target, current, buffer, lastScore);
-    double bestEnergy = bestState.m_score;
+    geometrize::core::Candidate bestState{geometrize::ShapeVariant(), 0, static_cast<std::uint8_t>(alpha)};
+    createCandidateShape(shapeCreator, space, bestState.shape);
+    bestState.score = scoreShape(bestState.shape, space, bestState.alpha, target, current, buffer, geometrize::core::noEnergyBound, energyFunction).value;
+    std::int64_t bestEnergy{bestState.score};
 
+    // Each candidate is created in place of the last, and swapped with the best when it beats it
+    geometrize::core::Candidate state{geometrize::ShapeVariant(), 0, static_cast<std::uint8_t>(alpha)};
     for(std::uint32_t i = 0; i <= n; i++) {
-        geometrize::State state(shapeCreator(), alpha);
-        state.m_score = energyFunction(state.m_shape->rasterize(*state.m_shape), state.m_alpha, target, current, buffer, lastScore);
-        const double energy = state.m_score;
-        if(i == 0 || energy < bestEnergy) {
-            bestEnergy = energy;
-            bestState = state;
+        createCandidateShape(shapeCreator, space, state.shape);
+        const geometrize::core::Energy energy{scoreShape(state.shape, space, state.alpha, target, current, buffer, i == 0 ? geometrize::core::noEnergyBound : bestEnergy, energyFunction)};
+        state.score = energy.value;
+        if(i == 0 || (energy.finished && energy.value < bestEnergy)) {
+            bestEnergy = energy.value;
+            std::swap(bestState, state);
         }
     }
 
     return bestState;
 }
 
+/**
+ * @brief bestRandomStates Generates random states and keeps the best few, see geometrize::core::bestRandomStates.
+ */
+template<typename EnergyT>
+std::vector<geometrize::core::Candidate> bestRandomStates(
+        const std::function<geometrize::ShapeVariant(void)>& shapeCreator,
+        const geometrize::ShapeSpace& space,
+        const std::uint32_t alpha,
+        const std::uint32_t n,
+        const std::uint32_t count,
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& current,
+        geometrize::Bitmap& buffer,
+        const EnergyT& e)
+{
+    // Kept sorted by score, once full a candidate only has to beat the worst of them
+    std::vector<geometrize::core::Candidate> states;
+    states.reserve(count + 1U);
+    geometrize::core::Candidate state{geometrize::ShapeVariant(), 0, static_cast<std::uint8_t>(alpha)};
+    for(std::uint32_t i = 0; i < n && count > 0; i++) {
+        createCandidateShape(shapeCreator, space, state.shape);
+        const bool full{states.size() == count};
+        const geometrize::core::Energy energy{scoreShape(state.shape, space, state.alpha, target, current, buffer, full ? states.back().score : geometrize::core::noEnergyBound, e)};
+        if(!energy.finished || (full && energy.value >= states.back().score)) {
+            continue;
+        }
+        state.score = energy.value;
+        ::keepState(states, count, state);
+    }
+    return states;
+}
+
+/**
+ * @brief screenedRandomStates Generates random states and keeps the best few that pass a screen on a low resolution proxy, see geometrize::core::screenedRandomStates.
+ */
+template<typename EnergyT>
+std::vector<geometrize::core::Candidate> screenedRandomStates(
+        const std::function<geometrize::ShapeVariant(void)>& shapeCreator,
+        const geometrize::ShapeSpace& space,
+        const std::uint32_t alpha,
+        const std::uint32_t n,
+        const std::uint32_t count,
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& current,
+        geometrize::Bitmap& buffer,
+        const geometrize::LowResolutionProxy& proxy,
+        const float ratio,
+        const bool audit,
+        geometrize::core::ScreeningStats& stats,
+        const EnergyT& e)
+{
+    assert(ratio > 0.0f && ratio <= 1.0f);
+    /**
+     * @brief The Survivor struct is a state that passed the screen so far, along with its scanlines so it needn't be rasterized again.
+     */
+    struct Survivor
+    {
+        geometrize::core::Candidate state; ///< The state, its score is the proxy energy.
+        std::vector<geometrize::Scanline> lines; ///< The scanlines of the shape.
+        std::uint32_t index; ///< The order the state was generated in.
+    };
+
+    // The first kept survivors are sorted by proxy score, ties go to the earlier candidate. The survivors and the candidate are kept by each thread
+    // and swapped around rather than copied, so once they have grown to fit the shapes being searched, screening allocates nothing
+    const std::uint32_t keep{(std::min)(n, (std::max)(count, static_cast<std::uint32_t>(std::ceil(static_cast<double>(n) * ratio))))};
+    thread_local std::vector<Survivor> survivors;
+    thread_local Survivor candidate;
+    thread_local std::vector<geometrize::Scanline> proxyLines;
+    std::uint32_t kept{0};
+
+    // When auditing, the best exact energy of any candidate
+    std::int64_t auditBest{geometrize::core::noEnergyBound};
+
+    for(std::uint32_t i = 0; i < n && keep > 0; i++) {
+        createCandidateShape(shapeCreator, space, candidate.state.shape);
+        candidate.state.alpha = static_cast<std::uint8_t>(alpha);
+        candidate.index = i;
+        geometrize::rasterize(candidate.state.shape, space, candidate.lines);
+        if(audit) {
+            auditBest = (std::min)(auditBest, e(candidate.lines, alpha, target, current, buffer, auditBest).value);
+        }
+
+        proxy.mapLines(candidate.lines, proxyLines);
+        candidate.state.score = geometrize::core::fusedEnergyFunction(proxyLines, alpha, proxy.getTarget(), proxy.getCurrent(), buffer, geometrize::core::noEnergyBound).value;
+        if(kept == keep && candidate.state.score >= survivors[kept - 1U].state.score) {
+            continue;
+        }
+        if(kept < keep) {
+            kept++;
+            if(survivors.size() < kept) {
+                survivors.emplace_back();
+            }
+        }
+        std::swap(survivors[kept - 1U], candidate);
+        const auto last = survivors.begin() + (kept - 1U);
+        const auto it = std::upper_bound(survivors.begin(), last, *last, [](const Survivor& a, const Survivor& b) {
+            return a.state.score < b.state.score;
+        });
+        std::rotate(it, last, last + 1);
+    }
+
+    // Score the survivors exactly, from best to worst on the proxy. The first is scored without a bound, so the best survivor always finishes
+    std::vector<geometrize::core::Candidate> states;
+    states.reserve(count + 1U);
+    std::int64_t survivorBest{geometrize::core::noEnergyBound};
+    std::uint32_t survivorBestIndex{0};
+    const std::uint32_t proxyBestIndex{kept > 0 ? survivors.front().index : 0U};
+    for(std::uint32_t s = 0; s < kept; s++) {
+        Survivor& survivor{survivors[s]};
+        const bool full{states.size() == count};
+        const geometrize::core::Energy energy{e(survivor.lines, alpha, target, current, buffer, full ? states.back().score : geometrize::core::noEnergyBound)};
+        if(!energy.finished || (full && energy.value >= states.back().score)) {
+            continue;
+        }
+        if(energy.value < survivorBest) {
+            survivorBest = energy.value;
+            survivorBestIndex = survivor.index;
+        }
+        survivor.state.score = energy.value;
+        ::keepState(states, count, survivor.state);
+    }
+
+    stats.screenings++;
+    stats.candidates += n;
+    stats.rescored += kept;
+    if(kept > 0 && survivorBestIndex != proxyBestIndex) {
+        stats.proxyBestOverruled++;
+    }
+    if(audit) {
+        stats.audits++;
+        if(survivorBest > auditBest) {
+            stats.exactBestScreenedOut++;
+        }
+    }
+    return states;
+}
+
+/**
+ * @brief colorFromMoments Calculates the color of some scanlines from the moments of the pixels they cover, exactly the same as computeColor would give.
+ * @param moments The moments of the covered pixels.
+ * @param alpha The alpha of the scanlines.
+ * @return The color of the scanlines.
+ */
+geometrize::rgba colorFromMoments(const geometrize::PixelMoments& moments, const std::uint32_t alpha)
+{
+    const geometrize::simd::ColorSums sums{
+        static_cast<std::int64_t>(moments.target[0]),
+        static_cast<std::int64_t>(moments.target[1]),
+        static_cast<std::int64_t>(moments.target[2]),
+        static_cast<std::int64_t>(moments.current[0]),
+        static_cast<std::int64_t>(moments.current[1]),
+        static_cast<std::int64_t>(moments.current[2])
+    };
+    return geometrize::core::computeColor(sums, static_cast<std::int64_t>(moments.count), static_cast<std::uint8_t>(alpha));
+}
+
+/**
+ * @brief energyFromMoments Calculates the energy of some scanlines from the moments of the pixels they cover.
+ * The color comes out exactly the same as computeColor would give, the error change is the closed-form estimate.
+ * @param moments The moments of the covered pixels.
+ * @param alpha The alpha of the scanlines.
+ * @return The energy measure.
+ */
+geometrize::core::Energy energyFromMoments(const geometrize::PixelMoments& moments, const std::uint32_t alpha)
+{
+    const geometrize::rgba color(::colorFromMoments(moments, alpha));
+    return geometrize::core::Energy{static_cast<std::int64_t>(std::llround(geometrize::estimateErrorDelta(moments, color))), true};
+}
+
+/**
+ * @brief The LineBestCase typedef pairs the best change in error a scanline could make, which is to remove all of its current error, with the index of the scanline.
+ */
+typedef std::pair<std::int64_t, std::size_t> LineBestCase;
+
+/**
+ * @brief computeColorAndBestCases Calculates the color of some scanlines the same as computeColor, and the best case for each scanline in the same pass over the pixels.
+ * @param target The target bitmap.
+ * @param current The current bitmap.
+ * @param lines The scanlines.
+ * @param alpha The alpha of the scanlines.
+ * @param bestCases The best cases of the non-empty scanlines, which are added to it.
+ * @return The color of the scanlines.
+ */
+geometrize::rgba computeColorAndBestCases(
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& current,
+        const std::vector<geometrize::Scanline>& lines,
+        const std::uint32_t alpha,
+        std::vector<LineBestCase>& bestCases)
+{
+    geometrize::simd::ColorSums sums{0, 0, 0, 0, 0, 0};
+    std::int64_t count{0};
+    for(std::size_t i = 0; i < lines.size(); i++) {
+        const geometrize::Scanline& line{lines[i]};
+        if(line.x2 < line.x1) {
+            continue;
+        }
+        const std::uint32_t y{static_cast<std::uint32_t>(line.y)};
+        const std::size_t offset{static_cast<std::size_t>(line.x1) * 4U};
+        const std::size_t length{static_cast<std::size_t>(line.x2 - line.x1 + 1)};
+        geometrize::simd::accumulateColorSums(target.row(y) + offset, current.row(y) + offset, length, sums);
+        bestCases.emplace_back(-geometrize::simd::squaredError(target.row(y) + offset, current.row(y) + offset, length), i); // The pixels are still in cache
+        count += static_cast<std::int64_t>(length);
+    }
+    return geometrize::core::computeColor(sums, count, static_cast<std::uint8_t>(alpha));
+}
+
+/**
+ * @brief boundedErrorDelta Sums the change in error of some scanlines, stopping as soon as the sum so far plus the best case for the remaining scanlines can't beat the bound.
+ * The scanlines with the most current error are visited first, so the best case for the rest shrinks as fast as possible.
+ * @param lines The scanlines.
+ * @param bestCases The best cases of the scanlines to visit, these are reordered.
+ * @param bound The energy to beat, or noEnergyBound to always visit every scanline.
+ * @param lineErrorDelta Gets the change in error of a scanline.
+ * @return The energy measure.
+ */
+template<typename LineErrorDeltaT>
+geometrize::core::Energy boundedErrorDelta(
+        const std::vector<geometrize::Scanline>& lines,
+        std::vector<LineBestCase>& bestCases,
+        const std::int64_t bound,
+        const LineErrorDeltaT& lineErrorDelta)
+{
+    std::int64_t bestCaseRemaining{0};
+    for(const LineBestCase& bestCase : bestCases) {
+        bestCaseRemaining += bestCase.first;
+    }
+    const bool bounded{bound != geometrize::core::noEnergyBound};
+    if(bounded) {
+        if(bestCaseRemaining >= bound) {
+            return geometrize::core::Energy{bestCaseRemaining, false};
+        }
+        std::sort(bestCases.begin(), bestCases.end());
+    }
+
+    std::int64_t delta{0};
+    for(const LineBestCase& bestCase : bestCases) {
+        delta += lineErrorDelta(lines[bestCase.second]);
+        bestCaseRemaining -= bestCase.first;
+        if(bounded && delta + bestCaseRemaining >= bound) {
+            return geometrize::core::Energy{delta + bestCaseRemaining, false};
+        }
+    }
+    return geometrize::core::Energy{delta, true};
+}
+
 }
 
 namespace geometrize
@@ -105,60 +657,173 @@ namespace geometrize
 namespace core
 {
 
-double defaultEnergyFunction(
+geometrize::core::Energy defaultEnergyFunction(
         const std::vector<geometrize::Scanline>& lines,
         const std::uint32_t alpha,
         const geometrize::Bitmap& target,
         const geometrize::Bitmap& current,
         geometrize::Bitmap& buffer,
-        const double score)
+        const std::int64_t bound)
 {
+    if(bound == geometrize::core::noEnergyBound) {
+        const geometrize::rgba color(geometrize::core::computeColor(target, current, lines, alpha)); // Calculate best color for areas covered by the scanlines
+        geometrize::copyLines(buffer, current, lines); // Copy area covered by scanlines to buffer bitmap
+        geometrize::drawLines(buffer, color, lines); // Blend scanlines into the buffer using the color calculated earlier
+        return geometrize::core::Energy{geometrize::core::differencePartial(target, current, buffer, lines), true}; // Get error measure between areas of current and modified buffers covered by scanlines
+    }
+
+    // With a bound, also get the current error of each scanline while calculating the color, so the error measure can stop once the bound is out of reach
+    thread_local std::vector<::LineBestCase> bestCases;
+    bestCases.clear();
+    const geometrize::rgba color(::computeColorAndBestCases(target, current, lines, alpha, bestCases));
+    std::int64_t bestCase{0};
+    for(const ::LineBestCase& line : bestCases) {
+        bestCase += line.first;
+    }
+    if(bestCase >= bound) {
+        return geometrize::core::Energy{bestCase, false}; // Not even removing all the error under the scanlines would beat the bound, so don't draw them
+    }
+
+    // Each scanline is copied and drawn to the buffer only when it is measured, so the scanlines skipped once the bound is out of reach are never drawn
+    // Like the fused energy function, this takes the scanlines of a shape not to overlap
+    return ::boundedErrorDelta(lines, bestCases, bound, [&target, &current, &buffer, color](const geometrize::Scanline& line) {
+        geometrize::copyLine(buffer, current, line);
+        geometrize::drawLine(buffer, color, line);
+        const std::uint32_t y{static_cast<std::uint32_t>(line.y)};
+        const std::size_t offset{static_cast<std::size_t>(line.x1) * 4U};
+        const std::size_t length{static_cast<std::size_t>(line.x2 - line.x1 + 1)};
+        return geometrize::simd::squaredErrorDelta(target.row(y) + offset, current.row(y) + offset, buffer.row(y) + offset, length);
+    });
+}
+
+geometrize::core::Energy fusedEnergyFunction(
+        const std::vector<geometrize::Scanline>& lines,
+        const std::uint32_t alpha,
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& current,
+        geometrize::Bitmap&,
+        const std::int64_t bound)
+{
+    if(bound != geometrize::core::noEnergyBound) {
+        // Get the current error of each scanline while calculating the color, so the error measure can stop once the bound is out of reach
+        thread_local std::vector<::LineBestCase> bestCases;
+        bestCases.clear();
+        const geometrize::simd::BlendColor blendColor(geometrize::simd::makeBlendColor(::computeColorAndBestCases(target, current, lines, alpha, bestCases)));
+        return ::boundedErrorDelta(lines, bestCases, bound, [&target, &current, &blendColor](const geometrize::Scanline& line) {
+            const std::uint32_t y{static_cast<std::uint32_t>(line.y)};
+            const std::size_t offset{static_cast<std::size_t>(line.x1) * 4U};
+            const std::size_t length{static_cast<std::size_t>(line.x2 - line.x1 + 1)};
+            return geometrize::simd::blendedErrorDelta(target.row(y) + offset, current.row(y) + offset, length, blendColor);
+        });
+    }
+
     const geometrize::rgba color(geometrize::core::computeColor(target, current, lines, alpha)); // Calculate best color for areas covered by the scanlines
-    geometrize::copyLines(buffer, current, lines); // Copy area covered by scanlines to buffer bitmap
-    geometrize::drawLines(buffer, color, lines); // Blend scanlines into the buffer using the color calculated earlier
-    return geometrize::core::differencePartial(target, current, buffer, score, lines); // Get error measure between areas of current and modified buffers covered by scanlines
+    const geometrize::simd::BlendColor blendColor(geometrize::simd::makeBlendColor(color));
+
+    // Measure the change in error the blended color would make, without writing the blended pixels anywhere
+    std::int64_t delta{0};
+    for(const geometrize::Scanline& line : lines) {
+        if(line.x2 < line.x1) {
+            continue;
+        }
+        const std::uint32_t y{static_cast<std::uint32_t>(line.y)};
+        const std::size_t offset{static_cast<std::size_t>(line.x1) * 4U};
+        const std::size_t length{static_cast<std::size_t>(line.x2 - line.x1 + 1)};
+        delta += geometrize::simd::blendedErrorDelta(target.row(y) + offset, current.row(y) + offset, length, blendColor);
+    }
+    return geometrize::core::Energy{delta, true};
 }
 
-geometrize::rgba computeColor(
+geometrize::core::Energy exactMomentEnergyFunction(
+        const std::vector<geometrize::Scanline>& lines,
+        const std::uint32_t alpha,
         const geometrize::Bitmap& target,
         const geometrize::Bitmap& current,
+        const geometrize::MomentTable& moments,
+        const std::int64_t bound)
+{
+    const geometrize::rgba color(::colorFromMoments(moments.getMoments(lines), alpha));
+    const geometrize::simd::BlendColor blendColor(geometrize::simd::makeBlendColor(color));
+
+    // The best any scanline can do is to match the target exactly, which would remove all of its current error
+    thread_local std::vector<::LineBestCase> bestCases;
+    bestCases.clear();
+    for(std::size_t i = 0; i < lines.size(); i++) {
+        if(lines[i].x2 < lines[i].x1) {
+            continue;
+        }
+        bestCases.emplace_back(-static_cast<std::int64_t>(moments.getSquaredError(lines[i])), i);
+    }
+
+    return ::boundedErrorDelta(lines, bestCases, bound, [&target, &current, &blendColor](const geometrize::Scanline& line) {
+        const std::uint32_t y{static_cast<std::uint32_t>(line.y)};
+        const std::size_t offset{static_cast<std::size_t>(line.x1) * 4U};
+        const std::size_t length{static_cast<std::size_t>(line.x2 - line.x1 + 1)};
+        return geometrize::simd::blendedErrorDelta(target.row(y) + offset, current.row(y) + offset, length, blendColor);
+    });
+}
+
+geometrize::core::Energy momentEnergyFunction(
         const std::vector<geometrize::Scanline>& lines,
-        const std::uint8_t alpha)
+        const std::uint32_t alpha,
+        const geometrize::MomentTable& moments)
+{
+    return ::energyFromMoments(moments.getMoments(lines), alpha);
+}
+
+geometrize::core::Energy summedAreaEnergyFunction(
+        const std::vector<geometrize::Scanline>& lines,
+        const std::uint32_t alpha,
+        const geometrize::SummedAreaTable& table)
 {
-    // Early out to avoid integer divide by 0
     if(lines.empty()) {
-        return geometrize::rgba{0, 0, 0, 0};
+        return ::energyFromMoments(geometrize::PixelMoments{{0, 0, 0, 0}, {0, 0, 0, 0}, 0, 0, 0, 0}, alpha);
     }
+    const geometrize::Scanline& first{lines.front()};
+    const geometrize::Scanline& last{lines.back()};
+    return ::energyFromMoments(table.getMoments(first.x1, first.y, first.x2, last.y), alpha);
+}
 
-    std::int64_t totalRed{0};
-    std::int64_t totalGreen{0};
-    std::int64_t totalBlue{0};
+geometrize::rgba computeColor(
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& current,
+        const std::vector<geometrize::Scanline>& lines,
+        const std::uint8_t alpha)
+{
+    // Sum the target and current colors under the scanlines, this is where most of the time goes so it is done by the vectorized kernels
+    geometrize::simd::ColorSums sums{0, 0, 0, 0, 0, 0};
     std::int64_t count{0};
-    const std::int32_t a{static_cast<std::int32_t>(257.0f * 255.0f / static_cast<float>(alpha))};
-
-    // For each scanline
     for(const geometrize::Scanline& line : lines) {
-        const std::int32_t y{line.y};
-        for(std::int32_t x = line.x1; x <= line.x2; x++) {
-            // Get the overlapping target and current colors
-            const geometrize::rgba t(target.getPixel(x, y));
-            const geometrize::rgba c(current.getPixel(x, y));
+        if(line.x2 < line.x1) {
+            continue;
+        }
+        const std::uint32_t y{static_cast<std::uint32_t>(line.y)};
+        const std::size_t offset{static_cast<std::size_t>(line.x1) * 4U};
+        const std::size_t length{static_cast<std::size_t>(line.x2 - line.x1 + 1)};
+        geometrize::simd::accumulateColorSums(target.row(y) + offset, current.row(y) + offset, length, sums);
+        count += static_cast<std::int64_t>(length);
+    }
 
-            const std::int32_t tr{t.r};
-            const std::int32_t tg{t.g};
-            const std::int32_t tb{t.b};
-            const std::int32_t cr{c.r};
-            const std::int32_t cg{c.g};
-            const std::int32_t cb{c.b};
+    return geometrize::core::computeColor(sums, count, alpha);
+}
 
-            // Mix the red, green and blue components, blending by the given alpha value
-            totalRed += static_cast<std::int64_t>((tr - cr) * a + cr * 257);
-            totalGreen += static_cast<std::int64_t>((tg - cg) * a + cg * 257);
-            totalBlue += static_cast<std::int64_t>((tb - cb) * a + cb * 257);
-            count++;
-        }
+geometrize::rgba computeColor(
+        const geometrize::simd::ColorSums& sums,
+        const std::int64_t count,
+        const std::uint8_t alpha)
+{
+    // Early out to avoid integer divide by 0
+    if(count == 0) {
+        return geometrize::rgba{0, 0, 0, 0};
     }
 
+    // Mix the red, green and blue components, blending by the given alpha value
+    // Summing (t - c) * a + c * 257 per pixel is the same as doing it once on the totals, so this is exact
+    const std::int32_t a{static_cast<std::int32_t>(257.0f * 255.0f / static_cast<float>(alpha))};
+    const std::int64_t totalRed{(sums.targetRed - sums.currentRed) * a + sums.currentRed * 257};
+    const std::int64_t totalGreen{(sums.targetGreen - sums.currentGreen) * a + sums.currentGreen * 257};
+    const std::int64_t totalBlue{(sums.targetBlue - sums.currentBlue) * a + sums.currentBlue * 257};
+
     const std::int32_t rr{static_cast<std::int32_t>(totalRed / count) >> 8};
     const std::int32_t gg{static_cast<std::int32_t>(totalGreen / count) >> 8};
     const std::int32_t bb{static_cast<std::int32_t>(totalBlue / count) >> 8};
@@ -171,63 +836,53 @@ geometrize::rgba computeColor(
     return geometrize::rgba{r, g, b, alpha};
 }
 
-double differenceFull(const geometrize::Bitmap& first, const geometrize::Bitmap& second)
+std::uint64_t totalSquaredError(const geometrize::Bitmap& first, const geometrize::Bitmap& second)
 {
     assert(first.getWidth() == second.getWidth());
     assert(first.getHeight() == second.getHeight());
 
     const std::size_t width{first.getWidth()};
-    const std::size_t height{first.getHeight()};
+    const std::uint32_t height{first.getHeight()};
     std::uint64_t total{0};
 
-    for(std::size_t y = 0; y < height; y++) {
-        for(std::size_t x = 0; x < width; x++) {
-            const geometrize::rgba f(first.getPixel(x, y));
-            const geometrize::rgba s(second.getPixel(x, y));
-
-            const std::int32_t dr = {static_cast<std::int32_t>(f.r) - static_cast<std::int32_t>(s.r)};
-            const std::int32_t dg = {static_cast<std::int32_t>(f.g) - static_cast<std::int32_t>(s.g)};
-            const std::int32_t db = {static_cast<std::int32_t>(f.b) - static_cast<std::int32_t>(s.b)};
-            const std::int32_t da = {static_cast<std::int32_t>(f.a) - static_cast<std::int32_t>(s.a)};
-            total += (dr * dr + dg * dg + db * db + da * da);
+    for(std::uint32_t y = 0; y < height; y++) {
+        const std::uint8_t* const f{first.row(y)};
+        const std::uint8_t* const s{second.row(y)};
+        for(std::size_t i = 0; i < width * 4U; i++) {
+            const std::int32_t d{static_cast<std::int32_t>(f[i]) - static_cast<std::int32_t>(s[i])};
+            total += static_cast<std::uint32_t>(d * d);
         }
     }
-    return std::sqrt(static_cast<double>(total) / (static_cast<double>(width) * static_cast<double>(height) * 4.0)) / 255.0;
+    return total;
+}
+
+double rootMeanSquareError(const std::uint64_t totalSquaredError, const std::uint32_t width, const std::uint32_t height)
+{
+    return std::sqrt(static_cast<double>(totalSquaredError) / (static_cast<double>(width) * static_cast<double>(height) * 4.0)) / 255.0;
 }
 
-double differencePartial(
+double differenceFull(const geometrize::Bitmap& first, const geometrize::Bitmap& second)
+{
+    return geometrize::core::rootMeanSquareError(geometrize::core::totalSquaredError(first, second), first.getWidth(), first.getHeight());
+}
+
+std::int64_t differencePartial(
         const geometrize::Bitmap& target,
         const geometrize::Bitmap& before,
         const geometrize::Bitmap& after,
-        const double score,
         const std::vector<Scanline>& lines)
 {
-    const std::uint64_t rgbaCount{target.getWidth() * target.getHeight() * 4U};
-    std::uint64_t total{static_cast<std::uint64_t>((score * 255.0) * (score * 255.0) * rgbaCount)};
+    std::int64_t delta{0};
     for(const geometrize::Scanline& line : lines) {
-        const std::int32_t y{line.y};
-        for(std::int32_t x = line.x1; x <= line.x2; x++) {
-            const geometrize::rgba t(target.getPixel(x, y));
-            const geometrize::rgba b(before.getPixel(x, y));
-            const geometrize::rgba a(after.getPixel(x, y));
-
-            const std::int32_t dtbr{static_cast<std::int32_t>(t.r) - static_cast<std::int32_t>(b.r)};
-            const std::int32_t dtbg{static_cast<std::int32_t>(t.g) - static_cast<std::int32_t>(b.g)};
-            const std::int32_t dtbb{static_cast<std::int32_t>(t.b) - static_cast<std::int32_t>(b.b)};
-            const std::int32_t dtba{static_cast<std::int32_t>(t.a) - static_cast<std::int32_t>(b.a)};
-
-            const std::int32_t dtar{static_cast<std::int32_t>(t.r) - static_cast<std::int32_t>(a.r)};
-            const std::int32_t dtag{static_cast<std::int32_t>(t.g) - static_cast<std::int32_t>(a.g)};
-            const std::int32_t dtab{static_cast<std::int32_t>(t.b) - static_cast<std::int32_t>(a.b)};
-            const std::int32_t dtaa{static_cast<std::int32_t>(t.a) - static_cast<std::int32_t>(a.a)};
-
-            total -= static_cast<std::uint64_t>(dtbr * dtbr + dtbg * dtbg + dtbb * dtbb + dtba * dtba);
-            total += static_cast<std::uint64_t>(dtar * dtar + dtag * dtag + dtab * dtab + dtaa * dtaa);
+        if(line.x2 < line.x1) {
+            continue;
         }
+        const std::uint32_t y{static_cast<std::uint32_t>(line.y)};
+        const std::size_t offset{static_cast<std::size_t>(line.x1) * 4U};
+        const std::size_t length{static_cast<std::size_t>(line.x2 - line.x1 + 1)};
+        delta += geometrize::simd::squaredErrorDelta(target.row(y) + offset, before.row(y) + offset, after.row(y) + offset, length);
     }
-
-    const double result{std::sqrt(static_cast<double>(total) / static_cast<double>(rgbaCount)) / 255.0};
-    return result;
+    return delta;
 }
 
 geometrize::State bestHillClimbState(
@@ -238,13 +893,90 @@ geometrize::State bestHillClimbState(
         const geometrize::Bitmap& target,
         const geometrize::Bitmap& current,
         geometrize::Bitmap& buffer,
-        const double lastScore,
         const EnergyFunction& customEnergyFunction)
 {
-    const EnergyFunction& e = customEnergyFunction ? customEnergyFunction : geometrize::core::defaultEnergyFunction;
+    // Custom shapes keep their own functions, so the space is unused
+    const geometrize::ShapeSpace space{};
+    const geometrize::core::Candidate candidate{bestHillClimbState([&shapeCreator]() { return geometrize::createShape(shapeCreator); },
+            space, alpha, n, age, target, current, buffer, customEnergyFunction)};
+
+    geometrize::State state;
+    state.m_score = candidate.score;
+    state.m_alpha = candidate.alpha;
+    state.m_shape = candidate.shape.getCustom();
+    return state;
+}
 
-    const geometrize::State state{bestRandomState(shapeCreator, alpha, n, target, current, buffer, lastScore, e)};
-    return ::hillClimb(state, age, target, current, buffer, lastScore, e);
+geometrize::core::Candidate bestHillClimbState(
+        const std::function<geometrize::ShapeVariant(void)>& shapeCreator,
+        const geometrize::ShapeSpace& space,
+        const std::uint32_t alpha,
+        const std::uint32_t n,
+        const std::uint32_t age,
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& current,
+        geometrize::Bitmap& buffer,
+        const EnergyFunction& customEnergyFunction)
+{
+    if(customEnergyFunction) {
+        const geometrize::core::Candidate state{::bestRandomState(shapeCreator, space, alpha, n, target, current, buffer, customEnergyFunction)};
+        return ::hillClimb(state, space, age, target, current, buffer, customEnergyFunction);
+    }
+    const geometrize::core::Candidate state{::bestRandomState(shapeCreator, space, alpha, n, target, current, buffer, DefaultEnergy{})};
+    return ::hillClimb(state, space, age, target, current, buffer, DefaultEnergy{});
+}
+
+std::vector<geometrize::core::Candidate> bestRandomStates(
+        const std::function<geometrize::ShapeVariant(void)>& shapeCreator,
+        const geometrize::ShapeSpace& space,
+        const std::uint32_t alpha,
+        const std::uint32_t n,
+        const std::uint32_t count,
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& current,
+        geometrize::Bitmap& buffer,
+        const EnergyFunction& customEnergyFunction)
+{
+    if(customEnergyFunction) {
+        return ::bestRandomStates(shapeCreator, space, alpha, n, count, target, current, buffer, customEnergyFunction);
+    }
+    return ::bestRandomStates(shapeCreator, space, alpha, n, count, target, current, buffer, DefaultEnergy{});
+}
+
+std::vector<geometrize::core::Candidate> screenedRandomStates(
+        const std::function<geometrize::ShapeVariant(void)>& shapeCreator,
+        const geometrize::ShapeSpace& space,
+        const std::uint32_t alpha,
+        const std::uint32_t n,
+        const std::uint32_t count,
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& current,
+        geometrize::Bitmap& buffer,
+        const geometrize::LowResolutionProxy& proxy,
+        const float ratio,
+        const bool audit,
+        geometrize::core::ScreeningStats& stats,
+        const EnergyFunction& customEnergyFunction)
+{
+    if(customEnergyFunction) {
+        return ::screenedRandomStates(shapeCreator, space, alpha, n, count, target, current, buffer, proxy, ratio, audit, stats, customEnergyFunction);
+    }
+    return ::screenedRandomStates(shapeCreator, space, alpha, n, count, target, current, buffer, proxy, ratio, audit, stats, DefaultEnergy{});
+}
+
+geometrize::core::Candidate hillClimbState(
+        const geometrize::core::Candidate& state,
+        const geometrize::ShapeSpace& space,
+        const std::uint32_t age,
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& current,
+        geometrize::Bitmap& buffer,
+        const EnergyFunction& customEnergyFunction)
+{
+    if(customEnergyFunction) {
+        return ::hillClimb(state, space, age, target, current, buffer, customEnergyFunction);
+    }
+    return ::hillClimb(state, space, age, target, current, buffer, DefaultEnergy{});
 }
 
 }
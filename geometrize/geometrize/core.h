@@ -7,11 +7,17 @@
 
 #include "bitmap/rgba.h"
 #include "rasterizer/scanline.h"
+#include "shape/shapevariant.h"
+#include "simd/kernels.h"
 #include "state.h"
 
 namespace geometrize
 {
 class Bitmap;
+class LowResolutionProxy;
+class MomentTable;
+struct ShapeSpace;
+class SummedAreaTable;
 }
 
 namespace geometrize
@@ -25,6 +31,44 @@ namespace core
  * @author Sam Twidale (https://samcodes.co.uk/)
  */
 
+/**
+ * @brief The Energy struct is the result of an energy function.
+ */
+struct Energy
+{
+    std::int64_t value; ///< The energy, the change in total squared error (over every channel of every pixel) that adding the shape would make. Negative values are improvements.
+    bool finished; ///< False if the energy function stopped early because the energy could not come in under the bound, in which case value is only a lower bound that is already at least the bound.
+};
+
+/**
+ * @brief The Candidate struct is a state the search is trying out. Unlike geometrize::State it holds its shape by value, so candidates can be copied
+ * and restored on every hill climbing step without cloning a shape on the heap. The shape is mutated and rasterized with the geometrize::ShapeSpace of the search.
+ */
+struct Candidate
+{
+    geometrize::ShapeVariant shape; ///< The shape.
+    std::int64_t score; ///< The change in total squared error adding the shape to the current bitmap would make (lower is better).
+    std::uint8_t alpha; ///< The alpha of the shape.
+};
+
+/**
+ * @brief The ScreeningStats struct counts how screening candidates on a low resolution proxy went, to judge how far the proxy's ranking can be trusted.
+ */
+struct ScreeningStats
+{
+    std::uint64_t screenings; ///< The number of times a set of candidates was screened.
+    std::uint64_t candidates; ///< The number of candidates scored on the proxy.
+    std::uint64_t rescored; ///< The number of candidates that passed the screen and were scored exactly.
+    std::uint64_t proxyBestOverruled; ///< The number of screenings where the candidate the proxy ranked best was not the best when scored exactly.
+    std::uint64_t audits; ///< The number of screenings where every candidate was also scored exactly, to check the screen.
+    std::uint64_t exactBestScreenedOut; ///< The number of audited screenings where the best candidate overall failed the screen.
+};
+
+/**
+ * @brief noEnergyBound A bound to pass to energy functions when the energy must always be calculated in full.
+ */
+const std::int64_t noEnergyBound{INT64_MAX};
+
 /**
  * @brief EnergyFunction Type alias for a function that calculates a measure of the improvement adding the scanlines of a shape provides - lower energy is better.
  * @param lines The scanlines of the shape.
@@ -32,34 +76,106 @@ namespace core
  * @param target The target bitmap.
  * @param current The current bitmap.
  * @param buffer The buffer bitmap.
- * @param score The score.
+ * @param bound The energy to beat. Once the energy is certain to be at least this the function may stop early and report it did not finish.
  * @return The energy measure.
  */
-using EnergyFunction = std::function<double(
+using EnergyFunction = std::function<geometrize::core::Energy(
     const std::vector<geometrize::Scanline>& lines,
     const std::uint32_t alpha,
     const geometrize::Bitmap& target,
     const geometrize::Bitmap& current,
     geometrize::Bitmap& buffer,
-    double score)>;
+    std::int64_t bound)>;
 
 /**
  * @brief defaultEnergyFunction The default/built-in energy function that calculates a measure of the improvement adding the scanlines of a shape provides - lower energy is better.
+ * Given a bound, the current error of each scanline is found along with the color. That is the most a scanline could improve things,
+ * so the error measure stops as soon as the error so far plus that best case for the rest can't beat the bound.
  * @param lines The scanlines of the shape.
  * @param alpha The alpha of the scanlines.
  * @param target The target bitmap.
  * @param current The current bitmap.
  * @param buffer The buffer bitmap.
- * @param score The score.
+ * @param bound The energy to beat.
  * @return The energy measure.
  */
-double defaultEnergyFunction(
+geometrize::core::Energy defaultEnergyFunction(
         const std::vector<geometrize::Scanline>& lines,
         const std::uint32_t alpha,
         const geometrize::Bitmap& target,
         const geometrize::Bitmap& current,
         geometrize::Bitmap& buffer,
-        double score);
+        std::int64_t bound);
+
+/**
+ * @brief fusedEnergyFunction A built-in energy function that calculates the same measure as defaultEnergyFunction without touching the buffer bitmap.
+ * It sums the target and current colors in one pass to get the shape color, then blends and measures the error in a second pass without storing the blended pixels.
+ * This roughly halves the memory traffic per candidate shape. The result matches defaultEnergyFunction exactly, provided no pixel is covered by more than one scanline.
+ * Given a bound, it stops early in the same way as defaultEnergyFunction.
+ * @param lines The scanlines of the shape.
+ * @param alpha The alpha of the scanlines.
+ * @param target The target bitmap.
+ * @param current The current bitmap.
+ * @param buffer The buffer bitmap (unused).
+ * @param bound The energy to beat.
+ * @return The energy measure.
+ */
+geometrize::core::Energy fusedEnergyFunction(
+        const std::vector<geometrize::Scanline>& lines,
+        const std::uint32_t alpha,
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& current,
+        geometrize::Bitmap& buffer,
+        std::int64_t bound);
+
+/**
+ * @brief exactMomentEnergyFunction An energy function that calculates the same measure as fusedEnergyFunction, using prefix-sum moment tables to save work.
+ * The shape color comes from the tables, so the pixels are only read once, to measure the error of the blended color.
+ * The tables also give the current error of every scanline, so the most the remaining scanlines could improve things is known as the pass goes.
+ * Given a bound, the pass stops as soon as the error so far plus that best case for the rest can't beat the bound.
+ * @param lines The scanlines of the shape.
+ * @param alpha The alpha of the scanlines.
+ * @param target The target bitmap.
+ * @param current The current bitmap.
+ * @param moments The moment tables for the target and current bitmaps.
+ * @param bound The energy to beat.
+ * @return The energy measure.
+ */
+geometrize::core::Energy exactMomentEnergyFunction(
+        const std::vector<geometrize::Scanline>& lines,
+        const std::uint32_t alpha,
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& current,
+        const geometrize::MomentTable& moments,
+        std::int64_t bound);
+
+/**
+ * @brief momentEnergyFunction An energy function that works from prefix-sum moment tables instead of the pixels, so it costs O(number of scanlines) rather than O(pixels).
+ * The shape color is exactly what computeColor would give, but the error is a closed-form estimate (rounded to the nearest integer) that ignores the rounding in drawLines,
+ * so the result is close to but not the same as defaultEnergyFunction. Suited to ranking candidates, the chosen shape should still be checked with differencePartial.
+ * @param lines The scanlines of the shape.
+ * @param alpha The alpha of the scanlines.
+ * @param moments The moment tables for the target and current bitmaps.
+ * @return The energy measure.
+ */
+geometrize::core::Energy momentEnergyFunction(
+        const std::vector<geometrize::Scanline>& lines,
+        const std::uint32_t alpha,
+        const geometrize::MomentTable& moments);
+
+/**
+ * @brief summedAreaEnergyFunction An energy function for scanlines that cover an axis-aligned rectangle, such as those of a geometrize::Rectangle.
+ * It works from 2D summed-area tables, so it takes the same few lookups whatever the size of the rectangle. The color is exact and the error is the same estimate as momentEnergyFunction.
+ * The scanlines must be one per row, in order of increasing y, all with the same x1 and x2 - only the first and last scanline are looked at.
+ * @param lines The scanlines of the shape.
+ * @param alpha The alpha of the scanlines.
+ * @param table The summed-area tables for the target and current bitmaps.
+ * @return The energy measure.
+ */
+geometrize::core::Energy summedAreaEnergyFunction(
+        const std::vector<geometrize::Scanline>& lines,
+        const std::uint32_t alpha,
+        const geometrize::SummedAreaTable& table);
 
 /**
  * @brief computeColor Calculates the color of the scanlines.
@@ -75,6 +191,35 @@ geometrize::rgba computeColor(
         const std::vector<geometrize::Scanline>& lines,
         std::uint8_t alpha);
 
+/**
+ * @brief computeColor Calculates the color of some scanlines from the sums of the target and current pixels they cover.
+ * @param sums The per-channel sums of the target and current pixels.
+ * @param count The number of pixels covered.
+ * @param alpha The alpha of the scanline.
+ * @return The color of the scanlines.
+ */
+geometrize::rgba computeColor(
+        const geometrize::simd::ColorSums& sums,
+        std::int64_t count,
+        std::uint8_t alpha);
+
+/**
+ * @brief totalSquaredError Calculates the sum of the squared differences between every channel of every pixel of two bitmaps.
+ * @param first The first bitmap.
+ * @param second The second bitmap.
+ * @return The total squared error between the two bitmaps.
+ */
+std::uint64_t totalSquaredError(const geometrize::Bitmap& first, const geometrize::Bitmap& second);
+
+/**
+ * @brief rootMeanSquareError Converts a total squared error into the normalized root-mean-square error used as the score.
+ * @param totalSquaredError The total squared error, summed over every channel of every pixel.
+ * @param width The width of the bitmaps.
+ * @param height The height of the bitmaps.
+ * @return The root-mean-square error, from 0 (identical) to 1.
+ */
+double rootMeanSquareError(std::uint64_t totalSquaredError, std::uint32_t width, std::uint32_t height);
+
 /**
  * @brief differenceFull Calculates the root-mean-square error between two bitmaps.
  * @param first The first bitmap.
@@ -84,20 +229,18 @@ geometrize::rgba computeColor(
 double differenceFull(const geometrize::Bitmap& first, const geometrize::Bitmap& second);
 
 /**
- * @brief differencePartial Calculates the root-mean-square error between the parts of the two bitmaps within the scanline mask.
+ * @brief differencePartial Calculates the change in total squared error between the target and a bitmap, for a change confined to the scanline mask.
  * This is for optimization purposes, it lets us calculate new error values only for parts of the image we know have changed.
  * @param target The target bitmap.
  * @param before The bitmap before the change.
  * @param after The bitmap after the change.
- * @param score The score.
  * @param lines The scanlines.
- * @return The difference/error between the two bitmaps, masked by the scanlines.
+ * @return The change in total squared error, negative if the change brought the bitmap closer to the target.
  */
-double differencePartial(
+std::int64_t differencePartial(
         const geometrize::Bitmap& target,
         const geometrize::Bitmap& before,
         const geometrize::Bitmap& after,
-        double score,
         const std::vector<Scanline>& lines);
 
 /**
@@ -109,7 +252,6 @@ double differencePartial(
  * @param target The target bitmap.
  * @param current The current bitmap.
  * @param buffer The buffer bitmap.
- * @param lastScore The last score.
  * @param customEnergyFunction An optional function to calculate the energy (if unspecified a default implementation is used).
  * @return The best state acquired from hill climbing i.e. the one with the lowest energy.
  */
@@ -121,7 +263,110 @@ geometrize::State bestHillClimbState(
         const geometrize::Bitmap& target,
         const geometrize::Bitmap& current,
         geometrize::Bitmap& buffer,
-        double lastScore,
+        const EnergyFunction& customEnergyFunction = nullptr);
+
+/**
+ * @brief bestHillClimbState Gets the best state using a hill climbing algorithm, searching over shapes held by value.
+ * The hill climb is specialized for the type of the shape and, if no custom energy function is given, for the default energy function, so the calls to mutate,
+ * rasterize and score the shape are direct rather than through std::function. Custom shapes and energy functions are called through their functions as usual.
+ * @param shapeCreator A function that will create the set up shapes that will be chosen from, or null to create the built-in shapes of the space.
+ * @param space The space the shapes are created in, used to mutate and rasterize them.
+ * @param alpha The opacity of the shape.
+ * @param n The number of random states to generate.
+ * @param age The number of hillclimbing steps.
+ * @param target The target bitmap.
+ * @param current The current bitmap.
+ * @param buffer The buffer bitmap.
+ * @param customEnergyFunction An optional function to calculate the energy (if unspecified a default implementation is used).
+ * @return The best state acquired from hill climbing i.e. the one with the lowest energy.
+ */
+geometrize::core::Candidate bestHillClimbState(
+        const std::function<geometrize::ShapeVariant(void)>& shapeCreator,
+        const geometrize::ShapeSpace& space,
+        std::uint32_t alpha,
+        std::uint32_t n,
+        std::uint32_t age,
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& current,
+        geometrize::Bitmap& buffer,
+        const EnergyFunction& customEnergyFunction = nullptr);
+
+/**
+ * @brief bestRandomStates Generates random states and keeps the best few, e.g. to hill climb them separately.
+ * @param shapeCreator A function that will create the set up shapes that will be chosen from, or null to create the built-in shapes of the space.
+ * @param space The space the shapes are created in.
+ * @param alpha The opacity of the shape.
+ * @param n The number of random states to generate.
+ * @param count The maximum number of states to keep.
+ * @param target The target bitmap.
+ * @param current The current bitmap.
+ * @param buffer The buffer bitmap.
+ * @param customEnergyFunction An optional function to calculate the energy (if unspecified a default implementation is used).
+ * @return Up to count of the generated states with the lowest energy, sorted from lowest to highest energy.
+ */
+std::vector<geometrize::core::Candidate> bestRandomStates(
+        const std::function<geometrize::ShapeVariant(void)>& shapeCreator,
+        const geometrize::ShapeSpace& space,
+        std::uint32_t alpha,
+        std::uint32_t n,
+        std::uint32_t count,
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& current,
+        geometrize::Bitmap& buffer,
+        const EnergyFunction& customEnergyFunction = nullptr);
+
+/**
+ * @brief screenedRandomStates Generates random states like bestRandomStates, but first ranks them on a low resolution proxy of the target and current bitmaps.
+ * Only the best fraction on the proxy are scored at full resolution. The proxy scores use fusedEnergyFunction on the downsampled bitmaps, so screening a candidate
+ * costs about 1/factor^2 of scoring it exactly, plus rasterizing it.
+ * @param shapeCreator A function that will create the set up shapes that will be chosen from, or null to create the built-in shapes of the space.
+ * @param space The space the shapes are created in.
+ * @param alpha The opacity of the shape.
+ * @param n The number of random states to generate.
+ * @param count The maximum number of states to keep.
+ * @param target The target bitmap.
+ * @param current The current bitmap.
+ * @param buffer The buffer bitmap.
+ * @param proxy The downsampled target and current bitmaps, must be up to date with the current bitmap.
+ * @param ratio The fraction of the states to score exactly, in (0, 1]. At least count states are always scored exactly.
+ * @param audit Whether to also score the states that fail the screen exactly, to count how often the screen drops the best state. This costs as much as not screening.
+ * @param stats The stats to add the results of the screening to.
+ * @param customEnergyFunction An optional function to calculate the exact energy (if unspecified a default implementation is used).
+ * @return Up to count of the states that passed the screen with the lowest exact energy, sorted from lowest to highest energy.
+ */
+std::vector<geometrize::core::Candidate> screenedRandomStates(
+        const std::function<geometrize::ShapeVariant(void)>& shapeCreator,
+        const geometrize::ShapeSpace& space,
+        std::uint32_t alpha,
+        std::uint32_t n,
+        std::uint32_t count,
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& current,
+        geometrize::Bitmap& buffer,
+        const geometrize::LowResolutionProxy& proxy,
+        float ratio,
+        bool audit,
+        geometrize::core::ScreeningStats& stats,
+        const EnergyFunction& customEnergyFunction = nullptr);
+
+/**
+ * @brief hillClimbState Improves a state using a hill climbing algorithm.
+ * @param state The state to start from, its score must be the energy of its shape.
+ * @param space The space the shape was created in.
+ * @param age The number of hillclimbing steps.
+ * @param target The target bitmap.
+ * @param current The current bitmap.
+ * @param buffer The buffer bitmap.
+ * @param customEnergyFunction An optional function to calculate the energy (if unspecified a default implementation is used).
+ * @return The best state acquired from hill climbing i.e. the one with the lowest energy.
+ */
+geometrize::core::Candidate hillClimbState(
+        const geometrize::core::Candidate& state,
+        const geometrize::ShapeSpace& space,
+        std::uint32_t age,
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& current,
+        geometrize::Bitmap& buffer,
         const EnergyFunction& customEnergyFunction = nullptr);
 
 }
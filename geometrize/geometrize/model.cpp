@@ -4,20 +4,31 @@
 #include <atomic>
 #include <cassert>
 #include <cstdint>
+#include <cstddef>
 #include <exception>
 #include <functional>
-#include <future>
 #include <iostream>
 #include <memory>
+#include <thread>
 #include <vector>
 
 #include "bitmap/bitmap.h"
+#include "bitmap/errormap.h"
+#include "bitmap/lowresolutionproxy.h"
+#include "bitmap/momenttable.h"
+#include "bitmap/pixelsnapshot.h"
+#include "bitmap/summedareatable.h"
 #include "commonutil.h"
 #include "core.h"
 #include "rasterizer/rasterizer.h"
+#include "rasterizer/scanline.h"
+#include "rasterizer/scanlinemask.h"
 #include "shape/shape.h"
+#include "shape/shapefactory.h"
 #include "shaperesult.h"
 #include "shape/shapetypes.h"
+#include "shape/shapevariant.h"
+#include "threadpool.h"
 
 namespace geometrize
 {
@@ -28,17 +39,17 @@ public:
     ModelImpl(const geometrize::Bitmap& target) :
         m_target{target},
         m_current{target.getWidth(), target.getHeight(), geometrize::commonutil::getAverageImageColor(m_target)},
-        m_lastScore{geometrize::core::differenceFull(m_target, m_current)},
+        m_totalError{geometrize::core::totalSquaredError(m_target, m_current)},
         m_baseRandomSeed{0U},
-        m_randomSeedOffset{0U}
+        m_stepCount{0U}
     {}
 
     ModelImpl(const geometrize::Bitmap& target, const geometrize::Bitmap& initial) :
         m_target{target},
         m_current{initial},
-        m_lastScore{geometrize::core::differenceFull(m_target, m_current)},
+        m_totalError{geometrize::core::totalSquaredError(m_target, m_current)},
         m_baseRandomSeed{0U},
-        m_randomSeedOffset{0U}
+        m_stepCount{0U}
     {
         assert(m_target.getWidth() == m_current.getWidth());
         assert(m_target.getHeight() == m_current.getHeight());
@@ -51,7 +62,20 @@ public:
     void reset(const geometrize::rgba backgroundColor)
     {
         m_current.fill(backgroundColor);
-        m_lastScore = geometrize::core::differenceFull(m_target, m_current);
+        m_totalError = geometrize::core::totalSquaredError(m_target, m_current);
+        invalidateWorkerBuffers();
+        if(m_moments) {
+            m_moments->update(m_target, m_current);
+        }
+        if(m_summedAreaTable) {
+            m_summedAreaTable->update(m_target, m_current);
+        }
+        if(m_errorMap) {
+            m_errorMap->update(m_target, m_current);
+        }
+        if(m_proxy) {
+            m_proxy->update(m_current);
+        }
     }
 
     std::int32_t getWidth() const
@@ -64,90 +88,281 @@ public:
         return m_target.getHeight();
     }
 
-    std::vector<geometrize::State> getHillClimbState(
-            const std::function<std::shared_ptr<geometrize::Shape>(void)> shapeCreator,
+    geometrize::core::EnergyFunction getTableEnergyFunction() const
+    {
+        // Score candidates from whichever tables are enabled - rectangles from the summed-area tables, anything else from the moment tables
+        const geometrize::MomentTable* const moments{m_moments.get()};
+        const geometrize::SummedAreaTable* const table{m_summedAreaTable.get()};
+        const bool exact{m_exactMomentEnergy};
+        if(table) {
+            return [moments, table, exact](const std::vector<geometrize::Scanline>& lines, const std::uint32_t alpha, const geometrize::Bitmap& target, const geometrize::Bitmap& current, geometrize::Bitmap& buffer, const std::int64_t bound) {
+                if(geometrize::scanlinesFormRectangle(lines)) {
+                    return geometrize::core::summedAreaEnergyFunction(lines, alpha, *table);
+                }
+                if(moments) {
+                    return exact ? geometrize::core::exactMomentEnergyFunction(lines, alpha, target, current, *moments, bound) : geometrize::core::momentEnergyFunction(lines, alpha, *moments);
+                }
+                return geometrize::core::defaultEnergyFunction(lines, alpha, target, current, buffer, bound);
+            };
+        }
+        if(moments && exact) {
+            return [moments](const std::vector<geometrize::Scanline>& lines, const std::uint32_t alpha, const geometrize::Bitmap& target, const geometrize::Bitmap& current, geometrize::Bitmap&, const std::int64_t bound) {
+                return geometrize::core::exactMomentEnergyFunction(lines, alpha, target, current, *moments, bound);
+            };
+        }
+        if(moments) {
+            return [moments](const std::vector<geometrize::Scanline>& lines, const std::uint32_t alpha, const geometrize::Bitmap&, const geometrize::Bitmap&, geometrize::Bitmap&, const std::int64_t) {
+                return geometrize::core::momentEnergyFunction(lines, alpha, *moments);
+            };
+        }
+        return nullptr;
+    }
+
+    std::vector<geometrize::core::Candidate> getHillClimbState(
+            const std::function<geometrize::ShapeVariant(void)>& shapeCreator,
+            const geometrize::ShapeSpace& space,
             const std::uint8_t alpha,
             const std::uint32_t shapeCount,
             const std::uint32_t maxShapeMutations,
-            std::uint32_t maxThreads,
+            const std::uint32_t maxThreads,
             const geometrize::core::EnergyFunction energyFunction)
     {
-        // Ensure that the maximum number of threads is a sane value
-        if(maxThreads == 0) {
-            maxThreads = std::thread::hardware_concurrency();
-            if(maxThreads == 0) {
-                assert(0 && "Failed to get the number of concurrent threads supported by the implementation");
-                maxThreads = defaultMaxThreads;
-            }
+        const geometrize::core::EnergyFunction e{energyFunction ? energyFunction : getTableEnergyFunction()};
+        prepareThreadPool(getThreadCount(maxThreads));
+
+        if(m_hillClimbCount > 0) {
+            return getPartitionedHillClimbState(shapeCreator, space, alpha, shapeCount, maxShapeMutations, e);
         }
 
-        std::vector<std::future<geometrize::State>> futures{maxThreads};
-        for(std::uint32_t i = 0; i < futures.size(); i++) {
-            std::future<geometrize::State> handle{std::async(std::launch::async, [&](const std::uint32_t seed, const double lastScore) {
-                // Ensure that the results of the random generation are the same between tasks with identical settings
-                // The RNG is thread-local and std::async may use a thread pool (which is why this is necessary)
-                // Note this implementation requires maxThreads to be the same between tasks for each task to produce the same results.
-                geometrize::commonutil::seedRandomGenerator(seed);
-
-                geometrize::Bitmap buffer{m_current};
-                return core::bestHillClimbState(shapeCreator, alpha, shapeCount, maxShapeMutations, m_target, m_current, buffer, lastScore, energyFunction);
-            }, m_baseRandomSeed + m_randomSeedOffset++, m_lastScore)};
-            futures[i] = std::move(handle);
-        }
-
-        std::vector<geometrize::State> states;
-
-        for(auto& f : futures) {
-            try {
-                states.emplace_back(f.get());
-            } catch(std::exception& e) {
-                assert(0 && "Encountered exception when getting hill climb state");
-                std::cout << e.what() << std::endl;
-                throw e;
-            } catch (...) {
-                assert(0 && "Encountered exception when getting hill climb state");
-                throw;
+        // Each task is an independent search with its own random stream, so the results don't depend on which worker runs the task
+        // The number of searches is fixed by maxThreads alone, not the machine, so a given seed and maxThreads give the same results anywhere
+        const std::uint32_t searchCount{maxThreads != 0 ? maxThreads : defaultSearchCount};
+        const std::uint32_t seed{m_baseRandomSeed};
+        const std::uint32_t step{m_stepCount++};
+
+        std::vector<geometrize::core::Candidate> states(searchCount);
+        std::vector<geometrize::core::ScreeningStats> stats(m_proxy ? searchCount : 0U, geometrize::core::ScreeningStats{});
+        runTasks(searchCount, [&](const std::size_t task, geometrize::Bitmap& buffer) {
+            geometrize::commonutil::seedRandomGenerator(seed, step, static_cast<std::uint32_t>(task));
+            if(!m_proxy) {
+                states[task] = core::bestHillClimbState(shapeCreator, space, alpha, shapeCount, maxShapeMutations, m_target, m_current, buffer, e);
+                return;
+            }
+            const std::vector<geometrize::core::Candidate> screened{core::screenedRandomStates(shapeCreator, space, alpha, shapeCount, 1U, m_target, m_current, buffer,
+                    *m_proxy, m_screeningRatio, m_auditScreening, stats[task], e)};
+            if(!screened.empty()) {
+                states[task] = core::hillClimbState(screened.front(), space, maxShapeMutations, m_target, m_current, buffer, e);
             }
+        });
+        addScreeningStats(stats);
+
+        // A task can come up empty if its screened candidates all missed the energy function's bound, so don't pass on unscored states
+        states.erase(std::remove_if(states.begin(), states.end(), [](const geometrize::core::Candidate& state) { return state.shape.isEmpty(); }), states.end());
+        return states;
+    }
+
+    std::vector<geometrize::core::Candidate> getPartitionedHillClimbState(
+            const std::function<geometrize::ShapeVariant(void)>& shapeCreator,
+            const geometrize::ShapeSpace& space,
+            const std::uint8_t alpha,
+            const std::uint32_t shapeCount,
+            const std::uint32_t maxShapeMutations,
+            const geometrize::core::EnergyFunction& e)
+    {
+        // Every candidate gets its own random stream, keyed by its index, so the candidates don't depend on how they are split between threads
+        const std::uint32_t candidateCount{(std::max)(shapeCount, 1U)};
+        const std::uint32_t batchCount{(candidateCount + candidatesPerTask - 1U) / candidatesPerTask};
+        const std::uint32_t seed{m_baseRandomSeed};
+        const std::uint32_t step{m_stepCount++};
+
+        std::vector<std::vector<geometrize::core::Candidate>> batches(batchCount);
+        std::vector<geometrize::core::ScreeningStats> stats(m_proxy ? batchCount : 0U, geometrize::core::ScreeningStats{});
+        runTasks(batchCount, [&](const std::size_t task, geometrize::Bitmap& buffer) {
+            std::uint32_t index{static_cast<std::uint32_t>(task) * candidatesPerTask};
+            const std::uint32_t n{(std::min)(candidatesPerTask, candidateCount - index)};
+            const std::function<geometrize::ShapeVariant(void)> seededShapeCreator{[&]() {
+                geometrize::commonutil::seedRandomGenerator(seed, step, index++);
+                return shapeCreator ? shapeCreator() : geometrize::createShape(space);
+            }};
+            if(m_proxy) {
+                batches[task] = core::screenedRandomStates(seededShapeCreator, space, alpha, n, m_hillClimbCount, m_target, m_current, buffer,
+                        *m_proxy, m_screeningRatio, m_auditScreening, stats[task], e);
+            } else {
+                batches[task] = core::bestRandomStates(seededShapeCreator, space, alpha, n, m_hillClimbCount, m_target, m_current, buffer, e);
+            }
+        });
+        addScreeningStats(stats);
+
+        // Keep the best candidates overall. The batches are in candidate order and sorted within, so ties go to the lowest candidate index
+        std::vector<geometrize::core::Candidate> candidates;
+        for(const std::vector<geometrize::core::Candidate>& batch : batches) {
+            candidates.insert(candidates.end(), batch.begin(), batch.end());
+        }
+        std::stable_sort(candidates.begin(), candidates.end(), [](const geometrize::core::Candidate& a, const geometrize::core::Candidate& b) {
+            return a.score < b.score;
+        });
+        if(candidates.size() > m_hillClimbCount) {
+            candidates.erase(candidates.begin() + m_hillClimbCount, candidates.end());
         }
+
+        std::vector<geometrize::core::Candidate> states(candidates.size());
+        runTasks(candidates.size(), [&](const std::size_t task, geometrize::Bitmap& buffer) {
+            geometrize::commonutil::seedRandomGenerator(seed, step, candidateCount + static_cast<std::uint32_t>(task));
+            states[task] = core::hillClimbState(candidates[task], space, maxShapeMutations, m_target, m_current, buffer, e);
+        });
         return states;
     }
 
     std::vector<geometrize::ShapeResult> step(
-            const std::function<std::shared_ptr<geometrize::Shape>(void)> shapeCreator,
+            const std::function<geometrize::ShapeVariant(void)>& shapeCreator,
+            const geometrize::ShapeSpace& space,
             const std::uint8_t alpha,
             const std::uint32_t shapeCount,
             const std::uint32_t maxShapeMutations,
             const std::uint32_t maxThreads,
             const geometrize::core::EnergyFunction& energyFunction)
     {
-        std::vector<geometrize::State> states{getHillClimbState(shapeCreator, alpha, shapeCount, maxShapeMutations, maxThreads, energyFunction)};
+        std::vector<geometrize::core::Candidate> states{getHillClimbState(shapeCreator, space, alpha, shapeCount, maxShapeMutations, maxThreads, energyFunction)};
         if(states.empty()) {
             assert(0 && "Failed to get a hill climb state");
             return {};
         }
 
-        std::vector<geometrize::State>::iterator it = std::min_element(states.begin(), states.end(), [](const geometrize::State& a, const geometrize::State& b) {
-            return a.m_score < b.m_score;
+        // Try the states from best to worst, ties go to the earlier state
+        std::stable_sort(states.begin(), states.end(), [](const geometrize::core::Candidate& a, const geometrize::core::Candidate& b) {
+            return a.score < b.score;
         });
 
-        // Draw the shape onto the image
-        const std::shared_ptr<geometrize::Shape> shape = it->m_shape;
-        const std::vector<geometrize::Scanline> lines{shape->rasterize(*shape)};
-        const geometrize::rgba color(geometrize::core::computeColor(m_target, m_current, lines, alpha));
-        const geometrize::Bitmap before{m_current};
-        geometrize::drawLines(m_current, color, lines);
+        // Greedily commit the best states whose shapes don't overlap a shape already committed in this step
+        // Shapes that cover separate pixels don't affect each other's energy, so each still gives the improvement it was scored with
+        std::vector<geometrize::ShapeResult> results;
+        std::vector<geometrize::Scanline> committedLines; // Only kept to clear the mask afterwards, the overlap tests go through the mask
+        for(const geometrize::core::Candidate& state : states) {
+            if(results.size() >= m_maxShapesPerStep) {
+                break;
+            }
+            const std::vector<geometrize::Scanline> lines{geometrize::rasterize(state.shape, space)};
+            if(!results.empty() && m_stepMask->overlaps(lines)) {
+                continue;
+            }
 
-        // Check for an improvement - if not, roll back and return no result
-        const double newScore = geometrize::core::differencePartial(m_target, before, m_current, m_lastScore, lines);
-        if(newScore >= m_lastScore) {
-            m_current = before;
-            return {};
+            // Draw the shape onto the image
+            const geometrize::rgba color(geometrize::core::computeColor(m_target, m_current, lines, alpha));
+            const geometrize::PixelSnapshot before{m_current, lines};
+            geometrize::drawLines(m_current, color, lines);
+
+            // Check for an improvement - if not, roll back and skip the shape
+            const std::int64_t delta{before.getErrorDelta(m_target, m_current)};
+            if(delta >= 0) {
+                before.restore(m_current);
+                continue;
+            }
+
+            // Improvement - set new baseline and keep the new shape
+            m_totalError += static_cast<std::uint64_t>(delta); // Wraps around, but the true total can't go negative
+            updateTables(lines);
+            markWorkerBuffersDirty(lines);
+            if(m_stepMask) {
+                m_stepMask->add(lines);
+                committedLines.insert(committedLines.end(), lines.begin(), lines.end());
+            }
+            results.push_back(geometrize::ShapeResult{getScore(), color, geometrize::createShape(state.shape, space)});
+        }
+        if(m_stepMask) {
+            m_stepMask->remove(committedLines);
         }
+        return results;
+    }
+
+    std::vector<geometrize::ShapeResult> stepTiled(
+            const geometrize::ShapeTypes types,
+            const std::uint8_t alpha,
+            const std::uint32_t shapeCount,
+            const std::uint32_t maxShapeMutations,
+            const std::uint32_t maxThreads,
+            const std::uint32_t tileSize,
+            std::uint32_t haloSize,
+            const geometrize::core::EnergyFunction& energyFunction)
+    {
+        assert(tileSize > 0);
+        haloSize = (std::min)(haloSize, tileSize / 2U); // Larger halos would overlap the halos of tiles two steps away
+
+        const geometrize::core::EnergyFunction e{energyFunction ? energyFunction : getTableEnergyFunction()};
+        prepareThreadPool(getThreadCount(maxThreads));
+
+        const std::int32_t width{getWidth()};
+        const std::int32_t height{getHeight()};
+        const std::int32_t size{static_cast<std::int32_t>(tileSize)};
+        const std::int32_t halo{static_cast<std::int32_t>(haloSize)};
+        const std::uint32_t columns{(static_cast<std::uint32_t>(width) + tileSize - 1U) / tileSize};
+        const std::uint32_t rows{(static_cast<std::uint32_t>(height) + tileSize - 1U) / tileSize};
+        const std::uint32_t seed{m_baseRandomSeed};
+        const std::uint32_t step{m_stepCount++};
+
+        /**
+         * @brief The TileCommit struct records the shape a tile drew, so the shared model state can be updated once all the tiles in a round are done.
+         */
+        struct TileCommit
+        {
+            std::shared_ptr<geometrize::Shape> shape; ///< The shape drawn, null if the tile found no improvement.
+            std::vector<geometrize::Scanline> lines; ///< The scanlines of the shape.
+            geometrize::rgba color; ///< The color the shape was drawn with.
+            std::int64_t delta; ///< The change in total squared error drawing the shape made.
+        };
+
+        // Tiles of the same parity in both directions are at least a tile apart, so with halos of at most half a tile their regions never touch
+        // Each round runs the tiles of one parity in parallel, each worker climbing and drawing shapes in its own region of the current bitmap
+        std::vector<geometrize::ShapeResult> results;
+        for(std::uint32_t parity = 0; parity < 4U; parity++) {
+            std::vector<std::uint32_t> tiles;
+            for(std::uint32_t ty = parity / 2U; ty < rows; ty += 2U) {
+                for(std::uint32_t tx = parity % 2U; tx < columns; tx += 2U) {
+                    tiles.push_back(ty * columns + tx);
+                }
+            }
+            if(tiles.empty()) {
+                continue;
+            }
 
-        // Improvement - set new baseline and return the new shape
-        m_lastScore = newScore;
-        const geometrize::ShapeResult result{m_lastScore, color, shape};
-        return { result };
+            syncWorkerBuffers(); // Workers only read and write their own region during the round
+            std::vector<TileCommit> commits(tiles.size());
+            runTasks(tiles.size(), [&](const std::size_t task, geometrize::Bitmap& buffer) {
+                const std::uint32_t tile{tiles[task]};
+                const std::int32_t x{static_cast<std::int32_t>(tile % columns) * size};
+                const std::int32_t y{static_cast<std::int32_t>(tile / columns) * size};
+                const geometrize::ShapeSpace space{types,
+                        (std::max)(x - halo, 0), (std::max)(y - halo, 0), (std::min)(x + size + halo, width), (std::min)(y + size + halo, height), nullptr};
+
+                geometrize::commonutil::seedRandomGenerator(seed, step, tile);
+                const geometrize::core::Candidate state{core::bestHillClimbState(nullptr, space, alpha, shapeCount, maxShapeMutations, m_target, m_current, buffer, e)};
+                if(state.score >= 0) {
+                    return;
+                }
+
+                TileCommit& commit{commits[task]};
+                commit.lines = geometrize::rasterize(state.shape, space);
+                commit.color = geometrize::core::computeColor(m_target, m_current, commit.lines, alpha);
+                const geometrize::PixelSnapshot before{m_current, commit.lines};
+                geometrize::drawLines(m_current, commit.color, commit.lines);
+                commit.delta = before.getErrorDelta(m_target, m_current);
+                if(commit.delta >= 0) {
+                    before.restore(m_current);
+                    return;
+                }
+                commit.shape = geometrize::createShape(state.shape, space);
+            });
+
+            for(const TileCommit& commit : commits) {
+                if(!commit.shape) {
+                    continue;
+                }
+                m_totalError += static_cast<std::uint64_t>(commit.delta);
+                updateTables(commit.lines);
+                markWorkerBuffersDirty(commit.lines);
+                results.push_back(geometrize::ShapeResult{getScore(), commit.color, commit.shape});
+            }
+        }
+        return results;
     }
 
     geometrize::ShapeResult drawShape(
@@ -155,15 +370,38 @@ public:
             const geometrize::rgba color)
     {
         const std::vector<geometrize::Scanline> lines{shape->rasterize(*shape)};
-        const geometrize::Bitmap before{m_current};
+        const geometrize::PixelSnapshot before{m_current, lines};
         geometrize::drawLines(m_current, color, lines);
 
-        m_lastScore = geometrize::core::differencePartial(m_target, before, m_current, m_lastScore, lines);
+        m_totalError += static_cast<std::uint64_t>(before.getErrorDelta(m_target, m_current));
+        updateTables(lines);
+        markWorkerBuffersDirty(lines);
 
-        const geometrize::ShapeResult result{m_lastScore, color, shape};
+        const geometrize::ShapeResult result{getScore(), color, shape};
         return result;
     }
 
+    geometrize::ShapeResult drawShapeIfImproved(
+            const std::shared_ptr<geometrize::Shape> shape,
+            const geometrize::rgba color)
+    {
+        const std::vector<geometrize::Scanline> lines{shape->rasterize(*shape)};
+        const geometrize::PixelSnapshot before{m_current, lines};
+        geometrize::drawLines(m_current, color, lines);
+
+        // Check for an improvement - if not, roll back and skip the shape
+        const std::int64_t delta{before.getErrorDelta(m_target, m_current)};
+        if(delta >= 0) {
+            before.restore(m_current);
+            return geometrize::ShapeResult{getScore(), color, nullptr};
+        }
+
+        m_totalError += static_cast<std::uint64_t>(delta);
+        updateTables(lines);
+        markWorkerBuffersDirty(lines);
+        return geometrize::ShapeResult{getScore(), color, shape};
+    }
+
     geometrize::Bitmap& getTarget()
     {
         return m_target;
@@ -189,15 +427,244 @@ public:
         m_baseRandomSeed = seed;
     }
 
+    void setThreadPool(const std::shared_ptr<geometrize::ThreadPool>& threadPool)
+    {
+        m_threadPool = threadPool;
+        m_ownsThreadPool = false;
+    }
+
+    std::shared_ptr<geometrize::ThreadPool> getThreadPool() const
+    {
+        return m_threadPool;
+    }
+
+    void setCandidatePartitioningEnabled(const bool enabled, const std::uint32_t hillClimbCount)
+    {
+        assert(!enabled || hillClimbCount > 0);
+        m_hillClimbCount = enabled ? hillClimbCount : 0;
+    }
+
+    void setMaxShapesPerStep(const std::uint32_t maxShapes)
+    {
+        assert(maxShapes > 0);
+        m_maxShapesPerStep = (std::max)(maxShapes, 1U);
+        if(m_maxShapesPerStep == 1U) {
+            m_stepMask.reset();
+        } else if(!m_stepMask) {
+            m_stepMask.reset(new geometrize::ScanlineMask(m_target.getWidth(), m_target.getHeight()));
+        }
+    }
+
+    void setSummedAreaTablesEnabled(const bool enabled)
+    {
+        if(!enabled) {
+            m_summedAreaTable.reset();
+        } else if(!m_summedAreaTable) {
+            m_summedAreaTable.reset(new geometrize::SummedAreaTable(m_target, m_current));
+        }
+    }
+
+    void setErrorMapEnabled(const bool enabled, const std::uint32_t cellSize)
+    {
+        if(!enabled) {
+            m_errorMap.reset();
+        } else if(!m_errorMap || m_errorMap->getCellSize() != cellSize) {
+            m_errorMap = std::make_shared<geometrize::ErrorMap>(m_target, m_current, cellSize);
+        }
+    }
+
+    std::shared_ptr<const geometrize::ErrorMap> getErrorMap() const
+    {
+        return m_errorMap;
+    }
+
+    void setScreeningEnabled(const bool enabled, const float ratio, const std::uint32_t factor, const bool audit)
+    {
+        assert(!enabled || (ratio > 0.0f && ratio <= 1.0f));
+        assert(!enabled || factor > 0);
+        m_screeningRatio = ratio;
+        m_auditScreening = audit;
+        if(!enabled) {
+            m_proxy.reset();
+        } else if(!m_proxy || m_proxy->getFactor() != factor) {
+            m_proxy.reset(new geometrize::LowResolutionProxy(m_target, m_current, factor));
+        }
+    }
+
+    geometrize::core::ScreeningStats getScreeningStats() const
+    {
+        return m_screeningStats;
+    }
+
+    void resetScreeningStats()
+    {
+        m_screeningStats = geometrize::core::ScreeningStats{};
+    }
+
+    void setMomentTablesEnabled(const bool enabled, const bool exact)
+    {
+        m_exactMomentEnergy = exact;
+        if(!enabled) {
+            m_moments.reset();
+        } else if(!m_moments) {
+            m_moments.reset(new geometrize::MomentTable(m_target, m_current));
+        }
+    }
+
 private:
+    /**
+     * @brief The WorkerBuffer struct is the scratch bitmap a pool worker passes to the energy function, kept between steps.
+     */
+    struct WorkerBuffer
+    {
+        std::unique_ptr<geometrize::Bitmap> bitmap; ///< Copy of the current bitmap, null until first used or after the current bitmap was reset.
+        std::vector<geometrize::Scanline> dirtyLines; ///< Scanlines drawn on the current bitmap since the copy was last synced.
+    };
+
+    std::uint32_t getThreadCount(const std::uint32_t maxThreads) const
+    {
+        // Ensure that the maximum number of threads is a sane value
+        if(maxThreads != 0) {
+            return maxThreads;
+        }
+        const std::uint32_t threads{std::thread::hardware_concurrency()};
+        if(threads == 0) {
+            assert(0 && "Failed to get the number of concurrent threads supported by the implementation");
+            return defaultMaxThreads;
+        }
+        return threads;
+    }
+
+    void prepareThreadPool(const std::uint32_t threadCount)
+    {
+        // Start the pool on first use, the threads and their buffers are then kept between steps
+        if(!m_threadPool || (m_ownsThreadPool && m_threadPool->getThreadCount() < threadCount)) {
+            m_threadPool = std::make_shared<geometrize::ThreadPool>(threadCount);
+            m_ownsThreadPool = true;
+        }
+        if(m_workers.size() < m_threadPool->getThreadCount()) {
+            m_workers.resize(m_threadPool->getThreadCount());
+        }
+    }
+
+    void runTasks(const std::size_t taskCount, const std::function<void(std::size_t, geometrize::Bitmap&)>& task)
+    {
+        try {
+            m_threadPool->run(taskCount, [this, &task](const std::size_t index, const std::size_t worker) {
+                task(index, syncWorkerBuffer(m_workers[worker]));
+            });
+        } catch(std::exception& e) {
+            assert(0 && "Encountered exception when getting hill climb state");
+            std::cout << e.what() << std::endl;
+            throw;
+        } catch (...) {
+            assert(0 && "Encountered exception when getting hill climb state");
+            throw;
+        }
+    }
+
+    geometrize::Bitmap& syncWorkerBuffer(WorkerBuffer& buffer) const
+    {
+        if(!buffer.bitmap) {
+            buffer.bitmap.reset(new geometrize::Bitmap(m_current));
+        } else {
+            geometrize::copyLines(*buffer.bitmap, m_current, buffer.dirtyLines);
+        }
+        buffer.dirtyLines.clear();
+        return *buffer.bitmap;
+    }
+
+    void syncWorkerBuffers()
+    {
+        for(WorkerBuffer& buffer : m_workers) {
+            syncWorkerBuffer(buffer);
+        }
+    }
+
+    void markWorkerBuffersDirty(const std::vector<geometrize::Scanline>& lines)
+    {
+        for(WorkerBuffer& buffer : m_workers) {
+            if(!buffer.bitmap) {
+                continue;
+            }
+            // Once a worker has fallen far behind, a fresh copy is cheaper than replaying every scanline
+            if(buffer.dirtyLines.size() + lines.size() > m_current.getHeight()) {
+                buffer.bitmap.reset();
+                buffer.dirtyLines.clear();
+                continue;
+            }
+            buffer.dirtyLines.insert(buffer.dirtyLines.end(), lines.begin(), lines.end());
+        }
+    }
+
+    void invalidateWorkerBuffers()
+    {
+        for(WorkerBuffer& buffer : m_workers) {
+            buffer.bitmap.reset();
+            buffer.dirtyLines.clear();
+        }
+    }
+
+    double getScore() const
+    {
+        return geometrize::core::rootMeanSquareError(m_totalError, m_target.getWidth(), m_target.getHeight());
+    }
+
+    void updateTables(const std::vector<geometrize::Scanline>& lines)
+    {
+        if(m_moments) {
+            m_moments->updateRows(m_target, m_current, lines);
+        }
+        if(m_summedAreaTable) {
+            m_summedAreaTable->updateRegion(m_target, m_current, lines);
+        }
+        if(m_errorMap) {
+            m_errorMap->updateCells(m_target, m_current, lines);
+        }
+        if(m_proxy) {
+            m_proxy->updatePixels(m_current, lines);
+        }
+    }
+
+    void addScreeningStats(const std::vector<geometrize::core::ScreeningStats>& stats)
+    {
+        for(const geometrize::core::ScreeningStats& s : stats) {
+            m_screeningStats.screenings += s.screenings;
+            m_screeningStats.candidates += s.candidates;
+            m_screeningStats.rescored += s.rescored;
+            m_screeningStats.proxyBestOverruled += s.proxyBestOverruled;
+            m_screeningStats.audits += s.audits;
+            m_screeningStats.exactBestScreenedOut += s.exactBestScreenedOut;
+        }
+    }
+
     geometrize::Bitmap m_target; ///< The target bitmap, the bitmap we aim to approximate.
     geometrize::Bitmap m_current; ///< The current bitmap.
-    double m_lastScore; ///< Score derived from calculating the difference between bitmaps.
+    std::uint64_t m_totalError; ///< The exact total squared error between the target and current bitmaps, the score is derived from this.
     const static std::uint32_t defaultMaxThreads{4};
+    const static std::uint32_t defaultSearchCount{4}; ///< The number of independent searches each step runs when maxThreads is 0, fixed so the results don't depend on the number of cores.
+    const static std::uint32_t candidatesPerTask{16}; ///< The number of random candidates each task tries when the candidates are partitioned between tasks.
     std::atomic<std::uint32_t> m_baseRandomSeed; ///< The base value used for seeding the random number generator (the one the user has control over).
-    std::atomic<std::uint32_t> m_randomSeedOffset; ///< Seed used for random number generation. Note: incremented by each std::async call used for model stepping.
+    std::atomic<std::uint32_t> m_stepCount; ///< The number of times the model was stepped, the random streams used in each step are keyed by this along with the base seed.
+    std::shared_ptr<geometrize::ThreadPool> m_threadPool; ///< The worker threads used for stepping, created on the first step unless one was set.
+    bool m_ownsThreadPool{false}; ///< Whether the thread pool was created by the model, rather than set by the user (and so may be resized by the model).
+    std::vector<WorkerBuffer> m_workers; ///< The scratch bitmaps, one for each pool worker.
+    std::uint32_t m_maxShapesPerStep{1}; ///< The maximum number of non-overlapping shapes to add in each step.
+    std::unique_ptr<geometrize::ScanlineMask> m_stepMask; ///< The pixels covered by the shapes added so far in the current step, null unless several shapes may be added per step.
+    std::uint32_t m_hillClimbCount{0}; ///< The number of best random candidates to hill climb when the candidates are partitioned between tasks, 0 when not partitioning.
+    std::unique_ptr<geometrize::MomentTable> m_moments; ///< Prefix-sum moment tables for the target and current bitmaps, null unless enabled.
+    bool m_exactMomentEnergy{false}; ///< Whether the moment tables are used for the exact energy rather than the closed-form estimate.
+    std::unique_ptr<geometrize::SummedAreaTable> m_summedAreaTable; ///< Summed-area tables for the target and current bitmaps, null unless enabled.
+    std::shared_ptr<geometrize::ErrorMap> m_errorMap; ///< Per-cell error between the target and current bitmaps for error-weighted shape placement, null unless enabled.
+    std::unique_ptr<geometrize::LowResolutionProxy> m_proxy; ///< Downsampled target and current bitmaps for screening candidates, null unless screening is enabled.
+    float m_screeningRatio{1.0f}; ///< The fraction of the random candidates that pass the screen and are scored exactly.
+    bool m_auditScreening{false}; ///< Whether the candidates that fail the screen are also scored exactly, to measure the screen.
+    geometrize::core::ScreeningStats m_screeningStats{}; ///< The screening results summed over every step since the stats were last reset.
 };
 
+const std::uint32_t Model::ModelImpl::defaultSearchCount;
+const std::uint32_t Model::ModelImpl::candidatesPerTask;
+
 Model::Model(const geometrize::Bitmap& target) : d{std::unique_ptr<Model::ModelImpl>(new Model::ModelImpl(target))}
 {}
 
@@ -230,7 +697,33 @@ std::vector<geometrize::ShapeResult> Model::step(
         const std::uint32_t maxThreads,
         const geometrize::core::EnergyFunction& energyFunction)
 {
-    return d->step(shapeCreator, alpha, shapeCount, maxShapeMutations, maxThreads, energyFunction);
+    // Custom shapes keep their own functions, so the space is unused
+    const geometrize::ShapeSpace space{};
+    return d->step([&shapeCreator]() { return geometrize::createShape(shapeCreator); }, space, alpha, shapeCount, maxShapeMutations, maxThreads, energyFunction);
+}
+
+std::vector<geometrize::ShapeResult> Model::step(
+        const geometrize::ShapeSpace& space,
+        const std::uint8_t alpha,
+        const std::uint32_t shapeCount,
+        const std::uint32_t maxShapeMutations,
+        const std::uint32_t maxThreads,
+        const geometrize::core::EnergyFunction& energyFunction)
+{
+    return d->step(nullptr, space, alpha, shapeCount, maxShapeMutations, maxThreads, energyFunction);
+}
+
+std::vector<geometrize::ShapeResult> Model::stepTiled(
+        const geometrize::ShapeTypes types,
+        const std::uint8_t alpha,
+        const std::uint32_t shapeCount,
+        const std::uint32_t maxShapeMutations,
+        const std::uint32_t maxThreads,
+        const std::uint32_t tileSize,
+        const std::uint32_t haloSize,
+        const geometrize::core::EnergyFunction& energyFunction)
+{
+    return d->stepTiled(types, alpha, shapeCount, maxShapeMutations, maxThreads, tileSize, haloSize, energyFunction);
 }
 
 geometrize::ShapeResult Model::drawShape(std::shared_ptr<geometrize::Shape> shape, geometrize::rgba color)
@@ -238,6 +731,11 @@ geometrize::ShapeResult Model::drawShape(std::shared_ptr<geometrize::Shape> shap
     return d->drawShape(shape, color);
 }
 
+geometrize::ShapeResult Model::drawShapeIfImproved(std::shared_ptr<geometrize::Shape> shape, geometrize::rgba color)
+{
+    return d->drawShapeIfImproved(shape, color);
+}
+
 geometrize::Bitmap& Model::getTarget()
 {
     return d->getTarget();
@@ -263,4 +761,59 @@ void Model::setSeed(const std::uint32_t seed)
     d->setSeed(seed);
 }
 
+void Model::setMomentTablesEnabled(const bool enabled, const bool exact)
+{
+    d->setMomentTablesEnabled(enabled, exact);
+}
+
+void Model::setThreadPool(const std::shared_ptr<geometrize::ThreadPool>& threadPool)
+{
+    d->setThreadPool(threadPool);
+}
+
+std::shared_ptr<geometrize::ThreadPool> Model::getThreadPool() const
+{
+    return d->getThreadPool();
+}
+
+void Model::setCandidatePartitioningEnabled(const bool enabled, const std::uint32_t hillClimbCount)
+{
+    d->setCandidatePartitioningEnabled(enabled, hillClimbCount);
+}
+
+void Model::setMaxShapesPerStep(const std::uint32_t maxShapes)
+{
+    d->setMaxShapesPerStep(maxShapes);
+}
+
+void Model::setErrorMapEnabled(const bool enabled, const std::uint32_t cellSize)
+{
+    d->setErrorMapEnabled(enabled, cellSize);
+}
+
+std::shared_ptr<const geometrize::ErrorMap> Model::getErrorMap() const
+{
+    return d->getErrorMap();
+}
+
+void Model::setSummedAreaTablesEnabled(const bool enabled)
+{
+    d->setSummedAreaTablesEnabled(enabled);
+}
+
+void Model::setScreeningEnabled(const bool enabled, const float ratio, const std::uint32_t factor, const bool audit)
+{
+    d->setScreeningEnabled(enabled, ratio, factor, audit);
+}
+
+geometrize::core::ScreeningStats Model::getScreeningStats() const
+{
+    return d->getScreeningStats();
+}
+
+void Model::resetScreeningStats()
+{
+    d->resetScreeningStats();
+}
+
 }
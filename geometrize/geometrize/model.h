@@ -7,11 +7,15 @@
 
 #include "core.h"
 #include "shaperesult.h"
+#include "shape/shapetypes.h"
 
 namespace geometrize
 {
 class Bitmap;
+class ErrorMap;
 class Shape;
+struct ShapeSpace;
+class ThreadPool;
 }
 
 namespace geometrize
@@ -65,7 +69,8 @@ public:
      * @param alpha The alpha of the shape.
      * @param shapeCount The number of random shapes to generate (only 1 is chosen in the end).
      * @param maxShapeMutations The maximum number of times to mutate each random shape.
-     * @param maxThreads The maximum number of threads to use during this step.
+     * @param maxThreads The number of parallel tasks to use during this step. These run on the model's thread pool, which is created with this many threads on the first step.
+     * If 0, the pool gets a thread for each core, and unless the candidates are partitioned a fixed number of tasks are run, so the results don't depend on the machine.
      * @param energyFunction An optional function to calculate the energy (if unspecified a default implementation is used).
      * @return A vector containing data about the shapes added to the model in this step. This may be empty if no shape that improved the image could be found.
      */
@@ -77,6 +82,51 @@ public:
             std::uint32_t maxThreads,
             const geometrize::core::EnergyFunction& energyFunction = nullptr);
 
+    /**
+     * @brief step Steps the primitive optimization/fitting algorithm, with the built-in shapes of a shape space. The search holds these shapes by value
+     * rather than creating and cloning shapes on the heap, so this is faster than passing the equivalent shape creator to the other overload.
+     * @param space The types, bounds and placement of the shapes to try, e.g. from geometrize::createShapeSpace.
+     * @param alpha The alpha of the shape.
+     * @param shapeCount The number of random shapes to generate (only 1 is chosen in the end).
+     * @param maxShapeMutations The maximum number of times to mutate each random shape.
+     * @param maxThreads The number of parallel tasks to use during this step. These run on the model's thread pool, which is created with this many threads on the first step.
+     * If 0, the pool gets a thread for each core, and unless the candidates are partitioned a fixed number of tasks are run, so the results don't depend on the machine.
+     * @param energyFunction An optional function to calculate the energy (if unspecified a default implementation is used).
+     * @return A vector containing data about the shapes added to the model in this step. This may be empty if no shape that improved the image could be found.
+     */
+    std::vector<geometrize::ShapeResult> step(
+            const geometrize::ShapeSpace& space,
+            std::uint8_t alpha,
+            std::uint32_t shapeCount,
+            std::uint32_t maxShapeMutations,
+            std::uint32_t maxThreads,
+            const geometrize::core::EnergyFunction& energyFunction = nullptr);
+
+    /**
+     * @brief stepTiled Steps the algorithm over the whole image in tiles, for very large targets. The image is split into square tiles, and shapes for each tile
+     * are created by the default shape creator confined to the tile plus a halo around it, so shapes can cross tile edges. Tiles are processed in four rounds,
+     * by the parity of their column and row, so the tiles in a round are at least a tile apart. Within a round every tile is hill climbed and drawn independently
+     * and in parallel, so a step can add a shape to every tile.
+     * @param types The types of shape to use.
+     * @param alpha The alpha of the shapes.
+     * @param shapeCount The number of random shapes to generate for each tile (only 1 is chosen in the end).
+     * @param maxShapeMutations The maximum number of times to mutate each random shape.
+     * @param maxThreads The number of threads to use, used to create the model's thread pool on first use.
+     * @param tileSize The width and height of the tiles in pixels.
+     * @param haloSize How far outside its tile a shape may reach in pixels, larger values are clamped to half of tileSize.
+     * @param energyFunction An optional function to calculate the energy (if unspecified a default implementation is used).
+     * @return A vector containing data about the shapes added to the model in this step, in the order they were added.
+     */
+    std::vector<geometrize::ShapeResult> stepTiled(
+            geometrize::ShapeTypes types,
+            std::uint8_t alpha,
+            std::uint32_t shapeCount,
+            std::uint32_t maxShapeMutations,
+            std::uint32_t maxThreads,
+            std::uint32_t tileSize,
+            std::uint32_t haloSize,
+            const geometrize::core::EnergyFunction& energyFunction = nullptr);
+
     /**
      * @brief drawShape Draws a shape on the model. Typically used when to manually add a shape to the image (e.g. when setting an initial background).
      * NOTE this unconditionally draws the shape, even if it increases the difference between the source and target image.
@@ -86,6 +136,14 @@ public:
      */
     geometrize::ShapeResult drawShape(std::shared_ptr<geometrize::Shape> shape, geometrize::rgba color);
 
+    /**
+     * @brief drawShapeIfImproved Draws a shape on the model only if it brings the current bitmap closer to the target, as the shapes found by step are.
+     * @param shape The shape to draw.
+     * @param color The color (including alpha) of the shape.
+     * @return Data about the shape drawn on the model, the shape is null if drawing it would not have improved the image and the model was left unchanged.
+     */
+    geometrize::ShapeResult drawShapeIfImproved(std::shared_ptr<geometrize::Shape> shape, geometrize::rgba color);
+
     /**
      * @brief getCurrent Gets the current bitmap.
      * @return The current bitmap.
@@ -111,11 +169,103 @@ public:
     const geometrize::Bitmap& getTarget() const;
 
     /**
-     * @brief setSeed Sets the seed that the random number generators of this model use. Note that the model also uses an internal seed offset which is incremented when the model is stepped.
+     * @brief setSeed Sets the seed that the random number generators of this model use. Note that the random streams are also keyed by an internal step counter which is incremented when the model is stepped.
      * @param seed The random number generator seed.
      */
     void setSeed(std::uint32_t seed);
 
+    /**
+     * @brief setThreadPool Sets the thread pool the model runs its step tasks on, e.g. so that several models can share one set of threads.
+     * The model keeps a scratch bitmap for each worker thread, synced with the current bitmap as shapes are added. If the current bitmap is modified
+     * through getCurrent(), energy functions should not rely on the contents of the buffer bitmap they are given.
+     * @param threadPool The thread pool to use. If null, the model creates its own pool on the next step.
+     */
+    void setThreadPool(const std::shared_ptr<geometrize::ThreadPool>& threadPool);
+
+    /**
+     * @brief getThreadPool Gets the thread pool the model runs its step tasks on.
+     * @return The thread pool, null if the model has not been stepped yet and no pool was set.
+     */
+    std::shared_ptr<geometrize::ThreadPool> getThreadPool() const;
+
+    /**
+     * @brief setMomentTablesEnabled Enables or disables the per-row prefix-sum moment tables. When enabled, step() scores candidate shapes with
+     * core::momentEnergyFunction in O(number of scanlines) instead of O(pixels), or with core::exactMomentEnergyFunction if exact is set,
+     * unless an energy function is passed explicitly. The chosen shape is still drawn and checked exactly. The tables cost about 56 bytes per pixel and
+     * are kept up to date as shapes are added; if the current bitmap is modified through getCurrent(), disable and re-enable the tables to rebuild them.
+     * @param enabled Whether to use the moment tables.
+     * @param exact Whether to use the tables to speed up the exact energy calculation instead of estimating it.
+     */
+    void setMomentTablesEnabled(bool enabled, bool exact = false);
+
+    /**
+     * @brief setCandidatePartitioningEnabled Sets how step() spends its search budget. By default every task runs all shapeCount random candidates and
+     * hill climbs the best, so the total work and the results depend on maxThreads (though not on the pool size, or the number of cores if maxThreads is 0). When partitioning is enabled the shapeCount candidates are instead split into small batches
+     * shared out between the pool workers, then the best hillClimbCount candidates overall are hill climbed in parallel. The work per step is then fixed
+     * and more threads make each step faster. Each candidate is generated from its own random stream and the best are chosen in candidate order,
+     * so for a given seed the results are the same for any maxThreads or thread pool size.
+     * @param enabled Whether to partition the candidates between tasks.
+     * @param hillClimbCount The number of best candidates to hill climb, must be greater than zero.
+     */
+    void setCandidatePartitioningEnabled(bool enabled, std::uint32_t hillClimbCount = 4);
+
+    /**
+     * @brief setMaxShapesPerStep Sets how many shapes step() may add at once. Each step produces one hill climbed state per task (or per hill climb when
+     * the candidates are partitioned). Normally only the best is added. With a higher limit the states are tried from best to worst, and each one whose
+     * scanlines don't overlap a shape already added in the step is added too, provided it improves the image. This is most useful on large images,
+     * where many of the states land on separate areas.
+     * @param maxShapes The maximum number of shapes to add per step, must be greater than zero. Defaults to 1.
+     */
+    void setMaxShapesPerStep(std::uint32_t maxShapes);
+
+    /**
+     * @brief setSummedAreaTablesEnabled Enables or disables the 2D summed-area tables. When enabled, step() scores candidates that rasterize to an axis-aligned
+     * rectangle with core::summedAreaEnergyFunction in a constant number of lookups, unless an energy function is passed explicitly. Other candidates are scored
+     * with the moment tables if those are enabled, else with the default energy function. The chosen shape is still drawn and checked exactly.
+     * The tables cost about 56 bytes per pixel; after each shape is added they are refreshed below and right of the shape's top-left corner.
+     * If the current bitmap is modified through getCurrent(), disable and re-enable the tables to rebuild them.
+     * @param enabled Whether to use the summed-area tables.
+     */
+    void setSummedAreaTablesEnabled(bool enabled);
+
+    /**
+     * @brief setErrorMapEnabled Enables or disables the error map, a grid of the error between the target and current bitmaps. It is kept up to date
+     * as shapes are added, and geometrize::createErrorWeightedShapeCreator can use it to place new shapes where the error is highest.
+     * If the current bitmap is modified through getCurrent(), disable and re-enable the map to rebuild it.
+     * @param enabled Whether to keep an error map.
+     * @param cellSize The width and height of the cells of the map in pixels.
+     */
+    void setErrorMapEnabled(bool enabled, std::uint32_t cellSize = 16);
+
+    /**
+     * @brief getErrorMap Gets the error map.
+     * @return The error map, null unless it is enabled.
+     */
+    std::shared_ptr<const geometrize::ErrorMap> getErrorMap() const;
+
+    /**
+     * @brief setScreeningEnabled Enables or disables screening the random candidates on a low resolution copy of the target and current bitmaps.
+     * When enabled, step() ranks the random candidates with cheap scores on the copy and only scores the best fraction of them exactly before hill climbing.
+     * The copy is kept up to date as shapes are added. Screening can drop a candidate that would have won, use getScreeningStats() to see how often.
+     * Tiled steps don't screen. If the current bitmap is modified through getCurrent(), disable and re-enable screening to rebuild the copy.
+     * @param enabled Whether to screen candidates.
+     * @param ratio The fraction of the candidates to score exactly, in (0, 1].
+     * @param factor The factor to downsample the bitmaps by, e.g. 2 for half or 4 for quarter resolution.
+     * @param audit Whether to also score the candidates that fail the screen, so the stats show how often the best candidate is dropped. This undoes the saving.
+     */
+    void setScreeningEnabled(bool enabled, float ratio, std::uint32_t factor = 2, bool audit = false);
+
+    /**
+     * @brief getScreeningStats Gets counts of how screening has gone since the model was created or the stats were last reset.
+     * @return The screening stats.
+     */
+    geometrize::core::ScreeningStats getScreeningStats() const;
+
+    /**
+     * @brief resetScreeningStats Sets the screening stats back to zero.
+     */
+    void resetScreeningStats();
+
 private:
     class ModelImpl;
     std::unique_ptr<Model::ModelImpl> d;
@@ -1,12 +1,14 @@
 #include "rasterizer.h"
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
-#include <map>
-#include <set>
+#include <cstring>
+#include <limits>
 #include <utility>
 #include <vector>
 
@@ -23,55 +25,27 @@
 #include "../shape/rotatedrectangle.h"
 #include "../shape/triangle.h"
 #include "scanline.h"
+#include "spanrasterizer.h"
 
-namespace geometrize
+namespace
 {
 
-std::vector<std::pair<float, float>> getCornerPoints(const geometrize::RotatedRectangle& r)
+/**
+ * @brief The PremultipliedColor struct is a color converted to alpha-premultiplied 16-bits per channel RGBA, ready to blend over pixels with blendLine.
+ */
+struct PremultipliedColor
 {
-    const float x1{(std::fmin)(r.m_x1, r.m_x2)};
-    const float x2{(std::fmax)(r.m_x1, r.m_x2)};
-    const float y1{(std::fmin)(r.m_y1, r.m_y2)};
-    const float y2{(std::fmax)(r.m_y1, r.m_y2)};
-
-    const float cx{(x2 + x1) / 2.0f};
-    const float cy{(y2 + y1) / 2.0f};
-
-    const float ox1{x1 - cx};
-    const float ox2{x2 - cx};
-    const float oy1{y1 - cy};
-    const float oy2{y2 - cy};
-
-    const float rads{r.m_angle * 3.141f / 180.0f};
-    const float c{std::cos(rads)};
-    const float s{std::sin(rads)};
-
-    const std::pair<float, float> ul{ox1 * c - oy1 * s + cx, ox1 * s + oy1 * c + cy};
-    const std::pair<float, float> bl{ox1 * c - oy2 * s + cx, ox1 * s + oy2 * c + cy};
-    const std::pair<float, float> ur{ox2 * c - oy1 * s + cx, ox2 * s + oy1 * c + cy};
-    const std::pair<float, float> br{ox2 * c - oy2 * s + cx, ox2 * s + oy2 * c + cy};
-
-    return {ul, ur, br, bl};
-}
-
-std::vector<std::pair<float, float>> getPointsOnRotatedEllipse(const geometrize::RotatedEllipse& e, const std::size_t numPoints)
-{    
-    std::vector<std::pair<float, float>> points;
-    const float rads{e.m_angle * (3.141f / 180.0f)};
-    const float co{std::cos(rads)};
-    const float si{std::sin(rads)};
-
-    for(std::uint32_t i = 0; i < numPoints; i++) {
-        const float angle{((360.0f / numPoints) * i) * (3.141f / 180.0f)};
-        const float crx{e.m_rx * std::cos(angle)};
-        const float cry{e.m_ry * std::sin(angle)};
-        points.push_back(std::make_pair(crx * co - cry * si + e.m_x, crx * si + cry * co + e.m_y));
-    }
-
-    return points;
-}
-
-void drawLines(geometrize::Bitmap& image, const geometrize::rgba color, const std::vector<geometrize::Scanline>& lines)
+    std::uint32_t sr; ///< The premultiplied red component.
+    std::uint32_t sg; ///< The premultiplied green component.
+    std::uint32_t sb; ///< The premultiplied blue component.
+    std::uint32_t sa; ///< The alpha component.
+    std::uint32_t aa; ///< The weight of the destination pixels.
+};
+
+/**
+ * @brief premultiplyColor Converts a non-premultiplied color for blending with blendLine.
+ */
+PremultipliedColor premultiplyColor(const geometrize::rgba color)
 {
     // Convert the non-premultiplied color to alpha-premultiplied 16-bits per channel RGBA
     // In other words, scale the rgb color components by the alpha component
@@ -91,35 +65,79 @@ void drawLines(geometrize::Bitmap& image, const geometrize::rgba color, const st
     sa |= sa << 8;
 
     const std::uint32_t m{UINT16_MAX};
-    const std::uint32_t aa{(m - sa) * 257U};
-
-    for(const geometrize::Scanline& line : lines) {
-        const std::int32_t y{line.y};
-
-        for(std::int32_t x = line.x1; x <= line.x2; x++) {
-            const geometrize::rgba d(image.getPixel(x, y));
-
-            const std::uint8_t r{static_cast<std::uint8_t>(((d.r * aa + sr * m) / m) >> 8)};
-            const std::uint8_t g{static_cast<std::uint8_t>(((d.g * aa + sg * m) / m) >> 8)};
-            const std::uint8_t b{static_cast<std::uint8_t>(((d.b * aa + sb * m) / m) >> 8)};
-            const std::uint8_t a{static_cast<std::uint8_t>(((d.a * aa + sa * m) / m) >> 8)};
+    return PremultipliedColor{sr, sg, sb, sa, (m - sa) * 257U};
+}
 
-            image.setPixel(x, y, geometrize::rgba{r, g, b, a});
-        }
+/**
+ * @brief blendLine Blends a color over the pixels of a scanline.
+ */
+void blendLine(geometrize::Bitmap& image, const PremultipliedColor& color, const geometrize::Scanline& line)
+{
+    if(line.x2 < line.x1) {
+        return;
+    }
+    const std::uint32_t m{UINT16_MAX};
+    std::uint8_t* d{image.row(static_cast<std::uint32_t>(line.y)) + static_cast<std::size_t>(line.x1) * 4U};
+    std::uint8_t* const end{d + static_cast<std::size_t>(line.x2 - line.x1 + 1) * 4U};
+    for(; d != end; d += 4U) {
+        d[0] = static_cast<std::uint8_t>(((d[0] * color.aa + color.sr * m) / m) >> 8);
+        d[1] = static_cast<std::uint8_t>(((d[1] * color.aa + color.sg * m) / m) >> 8);
+        d[2] = static_cast<std::uint8_t>(((d[2] * color.aa + color.sb * m) / m) >> 8);
+        d[3] = static_cast<std::uint8_t>(((d[3] * color.aa + color.sa * m) / m) >> 8);
     }
 }
 
-void copyLines(geometrize::Bitmap& destination, const geometrize::Bitmap& source, const std::vector<geometrize::Scanline>& lines)
+/**
+ * @brief rasterizeToVector Rasterizes a shape into a new vector, for the overloads of geometrize::rasterize that return one.
+ */
+template<typename ShapeT>
+std::vector<geometrize::Scanline> rasterizeToVector(const ShapeT& s, const std::int32_t xBound, const std::int32_t yBound)
 {
-    for(const geometrize::Scanline& line : lines) {
-        const std::int32_t y{line.y};
-        for(std::int32_t x = line.x1; x < line.x2; x++) {
-            destination.setPixel(x, y, source.getPixel(x, y));
-        }
-    }
+    std::vector<geometrize::Scanline> lines;
+    geometrize::rasterize(s, xBound, yBound, lines);
+    return lines;
 }
 
-std::vector<std::pair<std::int32_t, std::int32_t>> bresenham(std::int32_t x1, std::int32_t y1, const std::int32_t x2, const std::int32_t y2)
+/**
+ * @brief cornerPoints Gets the corner points of a rotated rectangle, see geometrize::getCornerPoints.
+ */
+std::array<std::pair<float, float>, 4> cornerPoints(const geometrize::RotatedRectangle& r)
+{
+    const float x1{(std::fmin)(r.m_x1, r.m_x2)};
+    const float x2{(std::fmax)(r.m_x1, r.m_x2)};
+    const float y1{(std::fmin)(r.m_y1, r.m_y2)};
+    const float y2{(std::fmax)(r.m_y1, r.m_y2)};
+
+    const float cx{(x2 + x1) / 2.0f};
+    const float cy{(y2 + y1) / 2.0f};
+
+    const float ox1{x1 - cx};
+    const float ox2{x2 - cx};
+    const float oy1{y1 - cy};
+    const float oy2{y2 - cy};
+
+    const float rads{r.m_angle * 3.141f / 180.0f};
+    const float c{std::cos(rads)};
+    const float s{std::sin(rads)};
+
+    const std::pair<float, float> ul{ox1 * c - oy1 * s + cx, ox1 * s + oy1 * c + cy};
+    const std::pair<float, float> bl{ox1 * c - oy2 * s + cx, ox1 * s + oy2 * c + cy};
+    const std::pair<float, float> ur{ox2 * c - oy1 * s + cx, ox2 * s + oy1 * c + cy};
+    const std::pair<float, float> br{ox2 * c - oy2 * s + cx, ox2 * s + oy2 * c + cy};
+
+    return {{ul, ur, br, bl}};
+}
+
+/**
+ * @brief forEachLinePoint Calls a function for each point on a line, in the same order and with the same points as geometrize::bresenham gives, without storing them.
+ * @param x1 The start x-coordinate.
+ * @param y1 The start y-coordinate.
+ * @param x2 The end x-coordinate.
+ * @param y2 The end y-coordinate.
+ * @param f The function to call with the x and y-coordinates of each point.
+ */
+template<typename Function>
+void forEachLinePoint(std::int32_t x1, std::int32_t y1, const std::int32_t x2, const std::int32_t y2, Function f)
 {
     std::int32_t dx{x2 - x1};
     const std::int8_t ix{static_cast<std::int8_t>((dx > 0) - (dx < 0))};
@@ -129,8 +147,7 @@ std::vector<std::pair<std::int32_t, std::int32_t>> bresenham(std::int32_t x1, st
     const std::int8_t iy{static_cast<std::int8_t>((dy > 0) - (dy < 0))};
     dy = std::abs(dy) << 1;
 
-    std::vector<std::pair<std::int32_t, std::int32_t>> points;
-    points.push_back(std::make_pair(x1, y1));
+    f(x1, y1);
 
     if (dx >= dy) {
         std::int32_t error(dy - (dx >> 1));
@@ -143,7 +160,7 @@ std::vector<std::pair<std::int32_t, std::int32_t>> bresenham(std::int32_t x1, st
             error += dy;
             x1 += ix;
 
-            points.push_back(std::make_pair(x1, y1));
+            f(x1, y1);
         }
     } else {
         std::int32_t error(dx - (dy >> 1));
@@ -156,220 +173,391 @@ std::vector<std::pair<std::int32_t, std::int32_t>> bresenham(std::int32_t x1, st
             error += dx;
             y1 += iy;
 
-            points.push_back(std::make_pair(x1, y1));
+            f(x1, y1);
         }
     }
+}
 
-    return points;
+/**
+ * @brief addStrokeSegment Adds the pixels of a line segment to a stroke. Where the segment runs along a row, its pixels extend the last scanline of the stroke rather than each getting their own.
+ * @param x1 The start x-coordinate.
+ * @param y1 The start y-coordinate.
+ * @param x2 The end x-coordinate.
+ * @param y2 The end y-coordinate.
+ * @param lines The scanlines of the stroke so far.
+ */
+void addStrokeSegment(const std::int32_t x1, const std::int32_t y1, const std::int32_t x2, const std::int32_t y2, std::vector<geometrize::Scanline>& lines)
+{
+    forEachLinePoint(x1, y1, x2, y2, [&lines](const std::int32_t x, const std::int32_t y) {
+        if(!lines.empty()) {
+            geometrize::Scanline& last{lines.back()};
+            if(last.y == y && x >= last.x1 - 1 && x <= last.x2 + 1) {
+                last.x1 = (std::min)(last.x1, x);
+                last.x2 = (std::max)(last.x2, x);
+                return;
+            }
+        }
+        lines.emplace_back(y, x, x);
+    });
 }
 
-std::vector<geometrize::Scanline> scanlinesForPolygon(const std::vector<std::pair<float, float>>& points)
+/**
+ * @brief finishStroke Sorts the scanlines of a stroke by row, clips them to the bounds, and merges any on the same row that overlap or touch, so each pixel is covered once.
+ * @param lines The scanlines of the stroke.
+ * @param xBound The width of the area to clip to.
+ * @param yBound The height of the area to clip to.
+ */
+void finishStroke(std::vector<geometrize::Scanline>& lines, const std::int32_t xBound, const std::int32_t yBound)
+{
+    std::sort(lines.begin(), lines.end(), [](const geometrize::Scanline& a, const geometrize::Scanline& b) {
+        return a.y < b.y || (a.y == b.y && a.x1 < b.x1);
+    });
+
+    std::size_t count{0};
+    for(std::size_t i = 0; i < lines.size(); i++) {
+        const geometrize::Scanline& line{lines[i]};
+        if(line.y < 0 || line.y >= yBound || line.x2 < 0 || line.x1 >= xBound) {
+            continue;
+        }
+        const geometrize::Scanline clipped(line.y, (std::max)(line.x1, 0), (std::min)(line.x2, xBound - 1));
+        if(count > 0 && lines[count - 1].y == clipped.y && clipped.x1 <= lines[count - 1].x2 + 1) {
+            lines[count - 1].x2 = (std::max)(lines[count - 1].x2, clipped.x2);
+        } else {
+            lines[count++] = clipped;
+        }
+    }
+    lines.resize(count);
+}
+
+/**
+ * @brief scanlinesForPolygon Gets the scanlines for a polygon, clipped to an area. Each row spans the leftmost to the rightmost point of the pixel outline of
+ * the polygon on that row, the outline being the Bresenham lines between its vertices (truncated to integers). Rows are filled in place in the output vector,
+ * so nothing is allocated if it already has the capacity for the rows of the polygon.
+ * @param points The vertices of the polygon.
+ * @param pointCount The number of vertices.
+ * @param xMin The left edge of the area, inclusive.
+ * @param yMin The top edge of the area, inclusive.
+ * @param xMax The right edge of the area, inclusive. Spans are clamped to the area horizontally rather than dropped.
+ * @param yMax The bottom edge of the area, inclusive.
+ * @param lines The vector to write the scanlines to, sorted by y. Its previous contents are discarded.
+ */
+void scanlinesForPolygon(
+        const std::pair<float, float>* const points,
+        const std::size_t pointCount,
+        const std::int32_t xMin,
+        const std::int32_t yMin,
+        const std::int32_t xMax,
+        const std::int32_t yMax,
+        std::vector<geometrize::Scanline>& lines)
+{
+    lines.clear();
+    if(pointCount == 0) {
+        return;
+    }
+
+    // The outline can't leave the bounding box of the vertices, so only the rows of that within the area need a span
+    std::int32_t first{(std::numeric_limits<std::int32_t>::max)()};
+    std::int32_t last{(std::numeric_limits<std::int32_t>::min)()};
+    for(std::size_t i = 0; i < pointCount; i++) {
+        const std::int32_t y{static_cast<std::int32_t>(points[i].second)};
+        first = (std::min)(first, y);
+        last = (std::max)(last, y);
+    }
+    first = (std::max)(first, yMin);
+    last = (std::min)(last, yMax);
+    if(first > last) {
+        return;
+    }
+
+    // Widen each row's span to cover the points of the outline on it, rows start out empty
+    lines.resize(static_cast<std::size_t>(last - first) + 1U);
+    for(std::size_t i = 0; i < lines.size(); i++) {
+        lines[i].y = first + static_cast<std::int32_t>(i);
+        lines[i].x1 = (std::numeric_limits<std::int32_t>::max)();
+        lines[i].x2 = (std::numeric_limits<std::int32_t>::min)();
+    }
+    for(std::size_t i = 0; i < pointCount; i++) {
+        const std::pair<float, float>& p1{points[i]};
+        const std::pair<float, float>& p2{points[i == pointCount - 1 ? 0U : i + 1U]};
+        forEachLinePoint(static_cast<std::int32_t>(p1.first), static_cast<std::int32_t>(p1.second),
+                static_cast<std::int32_t>(p2.first), static_cast<std::int32_t>(p2.second), [&lines, first, last](const std::int32_t x, const std::int32_t y) {
+            if(y >= first && y <= last) {
+                geometrize::Scanline& line{lines[static_cast<std::size_t>(y - first)]};
+                line.x1 = (std::min)(line.x1, x);
+                line.x2 = (std::max)(line.x2, x);
+            }
+        });
+    }
+
+    // Clamp the spans to the area, dropping any rows the outline missed
+    std::size_t count{0};
+    for(const geometrize::Scanline& line : lines) {
+        if(line.x1 <= line.x2) {
+            lines[count++] = geometrize::Scanline(line.y, geometrize::commonutil::clamp(line.x1, xMin, xMax), geometrize::commonutil::clamp(line.x2, xMin, xMax));
+        }
+    }
+    lines.resize(count);
+}
+
+}
+
+namespace geometrize
 {
-    std::vector<geometrize::Scanline> lines;
 
-    // Get the pixel outline of the polygon
-    std::vector<std::pair<std::int32_t, std::int32_t>> edges;
-    for(std::size_t i = 0; i < points.size(); i++) {
-        const std::pair<std::int32_t, std::int32_t> p1{static_cast<std::int32_t>(points[i].first), static_cast<std::int32_t>(points[i].second)};
-        const std::pair<std::int32_t, std::int32_t> p2{(i == (points.size() - 1)) ? std::make_pair(static_cast<std::int32_t>(points[0U].first), static_cast<std::int32_t>(points[0U].second)) : std::make_pair(static_cast<std::int32_t>(points[i + 1U].first), static_cast<std::int32_t>(points[i + 1U].second))};
-        const std::vector<std::pair<std::int32_t, std::int32_t>> p1p2{geometrize::bresenham(p1.first, p1.second, p2.first, p2.second)};
-        edges.insert(edges.end(), p1p2.begin(), p1p2.end());
+std::vector<std::pair<float, float>> getCornerPoints(const geometrize::RotatedRectangle& r)
+{
+    const std::array<std::pair<float, float>, 4> points{cornerPoints(r)};
+    return std::vector<std::pair<float, float>>(points.begin(), points.end());
+}
+
+std::vector<std::pair<float, float>> getPointsOnRotatedEllipse(const geometrize::RotatedEllipse& e, const std::size_t numPoints)
+{
+    std::vector<std::pair<float, float>> points;
+    const float rads{e.m_angle * (3.141f / 180.0f)};
+    const float co{std::cos(rads)};
+    const float si{std::sin(rads)};
+
+    for(std::uint32_t i = 0; i < numPoints; i++) {
+        const float angle{((360.0f / numPoints) * i) * (3.141f / 180.0f)};
+        const float crx{e.m_rx * std::cos(angle)};
+        const float cry{e.m_ry * std::sin(angle)};
+        points.push_back(std::make_pair(crx * co - cry * si + e.m_x, crx * si + cry * co + e.m_y));
+    }
+
+    return points;
+}
+
+void drawLines(geometrize::Bitmap& image, const geometrize::rgba color, const std::vector<geometrize::Scanline>& lines)
+{
+    const ::PremultipliedColor blendColor{::premultiplyColor(color)};
+    for(const geometrize::Scanline& line : lines) {
+        ::blendLine(image, blendColor, line);
     }
+}
 
-    // Convert outline to scanlines
-    std::map<std::int32_t, std::set<std::int32_t>> yToXs;
-    for(std::pair<std::int32_t, std::int32_t> point : edges) {
-        yToXs[point.second].insert(point.first);
+void drawLine(geometrize::Bitmap& image, const geometrize::rgba color, const geometrize::Scanline& line)
+{
+    ::blendLine(image, ::premultiplyColor(color), line);
+}
+
+void copyLines(geometrize::Bitmap& destination, const geometrize::Bitmap& source, const std::vector<geometrize::Scanline>& lines)
+{
+    for(const geometrize::Scanline& line : lines) {
+        copyLine(destination, source, line);
     }
-    for(const auto& it : yToXs) {
-        const geometrize::Scanline scanline(it.first,
-        *(std::min_element(it.second.begin(), it.second.end())),
-        *(std::max_element(it.second.begin(), it.second.end())));
-        lines.push_back(scanline);
+}
+
+void copyLine(geometrize::Bitmap& destination, const geometrize::Bitmap& source, const geometrize::Scanline& line)
+{
+    if(line.x2 < line.x1) {
+        return;
     }
+    const std::uint32_t y{static_cast<std::uint32_t>(line.y)};
+    const std::size_t offset{static_cast<std::size_t>(line.x1) * 4U};
+    const std::size_t length{static_cast<std::size_t>(line.x2 - line.x1 + 1) * 4U};
+    std::memcpy(destination.row(y) + offset, source.row(y) + offset, length);
+}
 
+std::vector<std::pair<std::int32_t, std::int32_t>> bresenham(const std::int32_t x1, const std::int32_t y1, const std::int32_t x2, const std::int32_t y2)
+{
+    std::vector<std::pair<std::int32_t, std::int32_t>> points;
+    forEachLinePoint(x1, y1, x2, y2, [&points](const std::int32_t x, const std::int32_t y) {
+        points.push_back(std::make_pair(x, y));
+    });
+    return points;
+}
+
+std::vector<geometrize::Scanline> scanlinesForPolygon(const std::vector<std::pair<float, float>>& points)
+{
+    std::vector<geometrize::Scanline> lines;
+    ::scanlinesForPolygon(points.data(), points.size(), (std::numeric_limits<std::int32_t>::min)(), (std::numeric_limits<std::int32_t>::min)(),
+            (std::numeric_limits<std::int32_t>::max)(), (std::numeric_limits<std::int32_t>::max)(), lines);
     return lines;
 }
 
-std::vector<geometrize::Scanline> rasterize(const geometrize::Shape& s, std::int32_t xBound, std::int32_t yBound)
+void scanlinesForPolygon(const std::pair<float, float>* const points, const std::size_t pointCount, const std::int32_t xBound, const std::int32_t yBound, std::vector<geometrize::Scanline>& lines)
+{
+    ::scanlinesForPolygon(points, pointCount, 0, 0, xBound - 1, yBound - 1, lines);
+}
+
+std::vector<geometrize::Scanline> rasterize(const geometrize::Shape& s, const std::int32_t xBound, const std::int32_t yBound)
+{
+    return rasterizeToVector(s, xBound, yBound);
+}
+
+void rasterize(const geometrize::Shape& s, const std::int32_t xBound, const std::int32_t yBound, std::vector<geometrize::Scanline>& lines)
 {
     switch(s.getType()) {
     case geometrize::ShapeTypes::RECTANGLE:
-        return rasterize(static_cast<const geometrize::Rectangle&>(s), xBound, yBound);
+        rasterize(static_cast<const geometrize::Rectangle&>(s), xBound, yBound, lines);
+        break;
     case geometrize::ShapeTypes::ROTATED_RECTANGLE:
-        return rasterize(static_cast<const geometrize::RotatedRectangle&>(s), xBound, yBound);
+        rasterize(static_cast<const geometrize::RotatedRectangle&>(s), xBound, yBound, lines);
+        break;
     case geometrize::ShapeTypes::TRIANGLE:
-        return rasterize(static_cast<const geometrize::Triangle&>(s), xBound, yBound);
+        rasterize(static_cast<const geometrize::Triangle&>(s), xBound, yBound, lines);
+        break;
     case geometrize::ShapeTypes::ELLIPSE:
-        return rasterize(static_cast<const geometrize::Ellipse&>(s), xBound, yBound);
+        rasterize(static_cast<const geometrize::Ellipse&>(s), xBound, yBound, lines);
+        break;
     case geometrize::ShapeTypes::ROTATED_ELLIPSE:
-        return rasterize(static_cast<const geometrize::RotatedEllipse&>(s), xBound, yBound);
+        rasterize(static_cast<const geometrize::RotatedEllipse&>(s), xBound, yBound, lines);
+        break;
     case geometrize::ShapeTypes::CIRCLE:
-        return rasterize(static_cast<const geometrize::Circle&>(s), xBound, yBound);
+        rasterize(static_cast<const geometrize::Circle&>(s), xBound, yBound, lines);
+        break;
     case geometrize::ShapeTypes::LINE:
-        return rasterize(static_cast<const geometrize::Line&>(s), xBound, yBound);
+        rasterize(static_cast<const geometrize::Line&>(s), xBound, yBound, lines);
+        break;
     case geometrize::ShapeTypes::QUADRATIC_BEZIER:
-        return rasterize(static_cast<const geometrize::QuadraticBezier&>(s), xBound, yBound);
+        rasterize(static_cast<const geometrize::QuadraticBezier&>(s), xBound, yBound, lines);
+        break;
     case geometrize::ShapeTypes::POLYLINE:
-        return rasterize(static_cast<const geometrize::Polyline&>(s), xBound, yBound);
+        rasterize(static_cast<const geometrize::Polyline&>(s), xBound, yBound, lines);
+        break;
     default:
         assert(0 && "Bad shape type");
-        return std::vector<geometrize::Scanline>{};
+        lines.clear();
     }
 }
 
 std::vector<geometrize::Scanline> rasterize(const geometrize::Circle& s, const std::int32_t xBound, const std::int32_t yBound)
 {
-    std::vector<geometrize::Scanline> lines;
-
-    const std::int32_t r{static_cast<std::int32_t>(s.m_r)};
-    for(std::int32_t y = -r; y <= r; y++) {
-        std::vector<std::int32_t> xScan;
-        for(std::int32_t x = -r; x <= r; x++) {
-            if(x * x + y * y <= r * r) {
-                xScan.push_back(x);
-            }
-        }
-
-        if(!xScan.empty()) {
-            const std::int32_t fy{static_cast<std::int32_t>(s.m_y) + y};
-            const std::int32_t x1{commonutil::clamp(static_cast<std::int32_t>(s.m_x) + xScan.front(), 0, xBound - 1)};
-            const std::int32_t x2{commonutil::clamp(static_cast<std::int32_t>(s.m_x) + xScan.back(), 0, xBound - 1)};
-            lines.push_back(geometrize::Scanline(fy, x1, x2));
-        }
-    }
-
-    return geometrize::trimScanlines(lines, xBound, yBound);
+    return rasterizeToVector(s, xBound, yBound);
 }
 
-std::vector<geometrize::Scanline> rasterize(const geometrize::Ellipse& s, const std::int32_t w, const std::int32_t h)
+void rasterize(const geometrize::Circle& s, const std::int32_t xBound, const std::int32_t yBound, std::vector<geometrize::Scanline>& lines)
 {
-    std::vector<geometrize::Scanline> lines;
-
-    const float aspect{static_cast<float>(s.m_rx) / static_cast<float>(s.m_ry)};
-
-    for (std::int32_t dy = 0; dy < s.m_ry; dy++) {
-        const std::int32_t y1{static_cast<std::int32_t>(s.m_y) - dy};
-        const std::int32_t y2{static_cast<std::int32_t>(s.m_y) + dy};
-
-        if ((y1 < 0 || y1 >= h) && (y2 < 0 || y2 >= h)) {
-            continue;
-        }
-
-        const std::int32_t v{static_cast<std::int32_t>(std::sqrt(s.m_ry * s.m_ry - dy * dy) * aspect)};
-        std::int32_t x1{static_cast<std::int32_t>(s.m_x) - v};
-        std::int32_t x2{static_cast<std::int32_t>(s.m_x) + v};
-        if (x1 < 0) {
-            x1 = 0;
-        }
-        if (x2 >= w) {
-            x2 = w - 1;
-        }
+    lines.clear();
+    lines.reserve(static_cast<std::size_t>((std::max)(2 * static_cast<std::int32_t>(s.m_r) + 1, 0)));
+    geometrize::forEachSpan(s, xBound, yBound, [&lines](const std::int32_t y, const std::int32_t x1, const std::int32_t x2) {
+        lines.emplace_back(y, x1, x2);
+    });
+}
 
-        if (y1 >= 0 && y1 < h) {
-            lines.push_back(Scanline(y1, x1, x2));
-        }
-        if (y2 >= 0 && y2 < h && dy > 0) {
-            lines.push_back(Scanline(y2, x1, x2));
-        }
-    }
+std::vector<geometrize::Scanline> rasterize(const geometrize::Ellipse& s, const std::int32_t xBound, const std::int32_t yBound)
+{
+    return rasterizeToVector(s, xBound, yBound);
+}
 
-    return geometrize::trimScanlines(lines, w, h);
+void rasterize(const geometrize::Ellipse& s, const std::int32_t w, const std::int32_t h, std::vector<geometrize::Scanline>& lines)
+{
+    lines.clear();
+    lines.reserve(static_cast<std::size_t>((std::max)(2 * static_cast<std::int32_t>(std::ceil(s.m_ry)) - 1, 0)));
+    geometrize::forEachSpan(s, w, h, [&lines](const std::int32_t y, const std::int32_t x1, const std::int32_t x2) {
+        lines.emplace_back(y, x1, x2);
+    });
 }
 
 std::vector<geometrize::Scanline> rasterize(const geometrize::Line& s, const std::int32_t xBound, const std::int32_t yBound)
 {
-    std::vector<geometrize::Scanline> lines;
-
-    const std::vector<std::pair<std::int32_t, std::int32_t>> points{geometrize::bresenham(static_cast<std::int32_t>(s.m_x1), static_cast<std::int32_t>(s.m_y1), static_cast<std::int32_t>(s.m_x2), static_cast<std::int32_t>(s.m_y2))};
-    for(const auto& point : points) {
-       lines.push_back(geometrize::Scanline(point.second, point.first, point.first));
-    }
+    return rasterizeToVector(s, xBound, yBound);
+}
 
-    return geometrize::trimScanlines(lines, xBound, yBound);
+void rasterize(const geometrize::Line& s, const std::int32_t xBound, const std::int32_t yBound, std::vector<geometrize::Scanline>& lines)
+{
+    lines.clear();
+    addStrokeSegment(static_cast<std::int32_t>(s.m_x1), static_cast<std::int32_t>(s.m_y1), static_cast<std::int32_t>(s.m_x2), static_cast<std::int32_t>(s.m_y2), lines);
+    finishStroke(lines, xBound, yBound);
 }
 
 std::vector<geometrize::Scanline> rasterize(const geometrize::Polyline& s, const std::int32_t xBound, const std::int32_t yBound)
 {
-    std::vector<geometrize::Scanline> lines;
+    return rasterizeToVector(s, xBound, yBound);
+}
 
+void rasterize(const geometrize::Polyline& s, const std::int32_t xBound, const std::int32_t yBound, std::vector<geometrize::Scanline>& lines)
+{
+    lines.clear();
     for(std::size_t i = 0; i < s.m_points.size(); i++) {
-        const std::pair<std::int32_t, std::int32_t> p0{s.m_points[i].first, s.m_points[i].second};
-        const std::pair<std::int32_t, std::int32_t> p1{i < (s.m_points.size() - 1) ? std::make_pair(static_cast<std::int32_t>(s.m_points[i + 1].first), static_cast<std::int32_t>(s.m_points[i + 1].second)) : p0};
-
-        const std::vector<std::pair<std::int32_t, std::int32_t>> points{geometrize::bresenham(p0.first, p0.second, p1.first, p1.second)};
-        for(const auto& point : points) {
-            lines.push_back(geometrize::Scanline(point.second, point.first, point.first));
-        }
+        const std::pair<float, float>& p0{s.m_points[i]};
+        const std::pair<float, float>& p1{i < (s.m_points.size() - 1) ? s.m_points[i + 1] : p0};
+        addStrokeSegment(static_cast<std::int32_t>(p0.first), static_cast<std::int32_t>(p0.second), static_cast<std::int32_t>(p1.first), static_cast<std::int32_t>(p1.second), lines);
     }
-
-    return geometrize::trimScanlines(lines, xBound, yBound);
+    finishStroke(lines, xBound, yBound);
 }
 
 std::vector<geometrize::Scanline> rasterize(const geometrize::QuadraticBezier& s, const std::int32_t xBound, const std::int32_t yBound)
 {
-    std::vector<geometrize::Scanline> scanlines;
+    return rasterizeToVector(s, xBound, yBound);
+}
+
+void rasterize(const geometrize::QuadraticBezier& s, const std::int32_t xBound, const std::int32_t yBound, std::vector<geometrize::Scanline>& lines)
+{
+    lines.clear();
 
-    std::vector<std::pair<std::int32_t, std::int32_t>> points;
     const std::uint32_t pointCount{20};
+    std::int32_t px{0};
+    std::int32_t py{0};
     for(std::uint32_t i = 0; i <= pointCount; i++) {
         const float t{static_cast<float>(i) / static_cast<float>(pointCount)};
         const float tp{1 - t};
         const std::int32_t x{static_cast<std::int32_t>(tp * (tp * s.m_x1 + (t * s.m_cx)) + t * ((tp * s.m_cx) + (t * s.m_x2)))};
         const std::int32_t y{static_cast<std::int32_t>(tp * (tp * s.m_y1 + (t * s.m_cy)) + t * ((tp * s.m_cy) + (t * s.m_y2)))};
-        points.push_back(std::make_pair(x, y));
-    }
-
-    for(std::uint32_t i = 0; i < points.size() - 1; i++) {
-        const std::pair<std::int32_t, std::int32_t> p0{points[i]};
-        const std::pair<std::int32_t, std::int32_t> p1{points[i + 1]};
-
-        const std::vector<std::pair<std::int32_t, std::int32_t>> points{geometrize::bresenham(static_cast<std::int32_t>(p0.first), static_cast<std::int32_t>(p0.second), static_cast<std::int32_t>(p1.first), static_cast<std::int32_t>(p1.second))};
-        for(const std::pair<std::int32_t, std::int32_t>& point : points) {
-            scanlines.push_back(geometrize::Scanline(point.second, point.first, point.first));
+        if(i > 0) {
+            addStrokeSegment(px, py, x, y, lines);
         }
+        px = x;
+        py = y;
     }
-
-    return geometrize::trimScanlines(scanlines, xBound, yBound);
+    finishStroke(lines, xBound, yBound);
 }
 
 std::vector<geometrize::Scanline> rasterize(const geometrize::Rectangle& s, const std::int32_t xBound, const std::int32_t yBound)
 {
-    const std::int32_t x1{static_cast<std::int32_t>((std::fmin)(s.m_x1, s.m_x2))};
-    const std::int32_t x2{static_cast<std::int32_t>((std::fmax)(s.m_x1, s.m_x2))};
-    const std::int32_t y1{static_cast<std::int32_t>((std::fmin)(s.m_y1, s.m_y2))};
-    const std::int32_t y2{static_cast<std::int32_t>((std::fmax)(s.m_y1, s.m_y2))};
+    return rasterizeToVector(s, xBound, yBound);
+}
 
-    std::vector<geometrize::Scanline> lines;
-    for(std::int32_t y = y1; y < y2; y++) {
-        lines.push_back(geometrize::Scanline(y, x1, x2));
-    }
-    return geometrize::trimScanlines(lines, xBound, yBound);
+void rasterize(const geometrize::Rectangle& s, const std::int32_t xBound, const std::int32_t yBound, std::vector<geometrize::Scanline>& lines)
+{
+    lines.clear();
+    lines.reserve(static_cast<std::size_t>(std::fabs(s.m_y2 - s.m_y1)) + 1U);
+    geometrize::forEachSpan(s, xBound, yBound, [&lines](const std::int32_t y, const std::int32_t x1, const std::int32_t x2) {
+        lines.emplace_back(y, x1, x2);
+    });
 }
 
 std::vector<geometrize::Scanline> rasterize(const geometrize::RotatedEllipse& s, const std::int32_t xBound, const std::int32_t yBound)
 {
-    const std::uint32_t pointCount{20};
-    std::vector<std::pair<float, float>> points = getPointsOnRotatedEllipse(s, pointCount);
+    return rasterizeToVector(s, xBound, yBound);
+}
 
-    std::vector<geometrize::Scanline> scanlines{geometrize::scanlinesForPolygon(points)};
-    return geometrize::trimScanlines(scanlines, xBound, yBound);
+void rasterize(const geometrize::RotatedEllipse& s, const std::int32_t xBound, const std::int32_t yBound, std::vector<geometrize::Scanline>& lines)
+{
+    lines.clear();
+    lines.reserve(static_cast<std::size_t>(2.0f * (std::max)(std::fabs(s.m_rx), std::fabs(s.m_ry))) + 1U);
+    geometrize::forEachSpan(s, xBound, yBound, [&lines](const std::int32_t y, const std::int32_t x1, const std::int32_t x2) {
+        lines.emplace_back(y, x1, x2);
+    });
 }
 
 std::vector<geometrize::Scanline> rasterize(const geometrize::RotatedRectangle& s, const std::int32_t xBound, const std::int32_t yBound)
 {
-    std::vector<geometrize::Scanline> scanlines{geometrize::scanlinesForPolygon(getCornerPoints(s))};
-    return geometrize::trimScanlines(scanlines, xBound, yBound);
+    return rasterizeToVector(s, xBound, yBound);
+}
+
+void rasterize(const geometrize::RotatedRectangle& s, const std::int32_t xBound, const std::int32_t yBound, std::vector<geometrize::Scanline>& lines)
+{
+    const std::array<std::pair<float, float>, 4> points{cornerPoints(s)};
+
+    lines.clear();
+    geometrize::scanlinesForPolygon(points.data(), points.size(), xBound, yBound, lines);
 }
 
 std::vector<geometrize::Scanline> rasterize(const geometrize::Triangle& s, const std::int32_t xBound, const std::int32_t yBound)
 {
-     std::vector<geometrize::Scanline> scanlines = geometrize::scanlinesForPolygon({
-         {static_cast<std::int32_t>(s.m_x1), static_cast<std::int32_t>(s.m_y1)},
-         {static_cast<std::int32_t>(s.m_x2), static_cast<std::int32_t>(s.m_y2)},
-         {static_cast<std::int32_t>(s.m_x3), static_cast<std::int32_t>(s.m_y3)}});
+    return rasterizeToVector(s, xBound, yBound);
+}
 
-    return geometrize::trimScanlines(scanlines, xBound, yBound);
+void rasterize(const geometrize::Triangle& s, const std::int32_t xBound, const std::int32_t yBound, std::vector<geometrize::Scanline>& lines)
+{
+    const std::array<std::pair<float, float>, 3> points{{
+        {static_cast<float>(static_cast<std::int32_t>(s.m_x1)), static_cast<float>(static_cast<std::int32_t>(s.m_y1))},
+        {static_cast<float>(static_cast<std::int32_t>(s.m_x2)), static_cast<float>(static_cast<std::int32_t>(s.m_y2))},
+        {static_cast<float>(static_cast<std::int32_t>(s.m_x3)), static_cast<float>(static_cast<std::int32_t>(s.m_y3))}}};
+
+    lines.clear();
+    geometrize::scanlinesForPolygon(points.data(), points.size(), xBound, yBound, lines);
 }
 
 bool scanlinesOverlap(const std::vector<geometrize::Scanline>& first, const std::vector<geometrize::Scanline>& second)
@@ -406,6 +594,21 @@ bool scanlinesContain(const std::vector<geometrize::Scanline>& first, const std:
     return true;
 }
 
+bool scanlinesFormRectangle(const std::vector<geometrize::Scanline>& lines)
+{
+    if(lines.empty() || lines.front().x2 < lines.front().x1) {
+        return false;
+    }
+    const geometrize::Scanline& first{lines.front()};
+    for(std::size_t i = 1; i < lines.size(); i++) {
+        const geometrize::Scanline& line{lines[i]};
+        if(line.y != first.y + static_cast<std::int32_t>(i) || line.x1 != first.x1 || line.x2 != first.x2) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool shapesOverlap(const geometrize::Shape& a, const geometrize::Shape& b, const std::int32_t xBound, const std::int32_t yBound)
 {
     return geometrize::scanlinesOverlap(geometrize::rasterize(a, xBound, yBound), geometrize::rasterize(b, xBound, yBound));
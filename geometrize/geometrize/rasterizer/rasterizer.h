@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <utility>
 #include <vector>
@@ -47,6 +48,14 @@ std::vector<std::pair<float, float>> getPointsOnRotatedEllipse(const geometrize:
  */
 void drawLines(geometrize::Bitmap& image, geometrize::rgba color, const std::vector<geometrize::Scanline>& lines);
 
+/**
+ * @brief drawLine Draws a single scanline onto an image, the same as drawLines would.
+ * @param image The image to be drawn to.
+ * @param color The color of the scanline.
+ * @param line The scanline to draw.
+ */
+void drawLine(geometrize::Bitmap& image, geometrize::rgba color, const geometrize::Scanline& line);
+
 /**
  * @brief copyLines Copies source pixels to a destination defined by a set of scanlines.
  * @param destination The destination bitmap to copy the lines to.
@@ -55,6 +64,14 @@ void drawLines(geometrize::Bitmap& image, geometrize::rgba color, const std::vec
  */
 void copyLines(geometrize::Bitmap& destination, const geometrize::Bitmap& source, const std::vector<geometrize::Scanline>& lines);
 
+/**
+ * @brief copyLine Copies the source pixels covered by a single scanline to a destination, the same as copyLines would.
+ * @param destination The destination bitmap to copy the line to.
+ * @param source The source bitmap to copy the line from.
+ * @param line The scanline to copy.
+ */
+void copyLine(geometrize::Bitmap& destination, const geometrize::Bitmap& source, const geometrize::Scanline& line);
+
 /**
  * @brief bresenham Bresenham's line algorithm. Returns the points on the line.
  * @param x1 The start x-coordinate.
@@ -72,6 +89,17 @@ std::vector<std::pair<std::int32_t, std::int32_t>> bresenham(std::int32_t x1, st
  */
 std::vector<geometrize::Scanline> scanlinesForPolygon(const std::vector<std::pair<float, float>>& points);
 
+/**
+ * @brief scanlinesForPolygon Gets the scanlines for a polygon, clipped to the given bounds, into a vector supplied by the caller.
+ * The scanlines are the same as the other overload gives, clamped as trimScanlines would, and sorted by y. Nothing is allocated if the vector can already hold a scanline for every row the polygon covers.
+ * @param points The vertices of the polygon.
+ * @param pointCount The number of vertices.
+ * @param xBound The width of the area to clip to.
+ * @param yBound The height of the area to clip to.
+ * @param lines The vector to write the scanlines to, its previous contents are discarded.
+ */
+void scanlinesForPolygon(const std::pair<float, float>* points, std::size_t pointCount, std::int32_t xBound, std::int32_t yBound, std::vector<geometrize::Scanline>& lines);
+
 std::vector<geometrize::Scanline> rasterize(const geometrize::Shape& s, std::int32_t xBound, std::int32_t yBound);
 std::vector<geometrize::Scanline> rasterize(const geometrize::Circle& s, std::int32_t xBound, std::int32_t yBound);
 std::vector<geometrize::Scanline> rasterize(const geometrize::Ellipse& s, std::int32_t xBound, std::int32_t yBound);
@@ -83,6 +111,25 @@ std::vector<geometrize::Scanline> rasterize(const geometrize::RotatedEllipse& s,
 std::vector<geometrize::Scanline> rasterize(const geometrize::RotatedRectangle& s, std::int32_t xBound, std::int32_t yBound);
 std::vector<geometrize::Scanline> rasterize(const geometrize::Triangle& s, std::int32_t xBound, std::int32_t yBound);
 
+/**
+ * @brief rasterize Rasterizes a shape into a vector supplied by the caller, replacing its contents. The scanlines are the same as the overloads above return,
+ * but nothing is allocated once the vector has grown to fit the shape, so a search can reuse one vector for all of its candidates.
+ * @param s The shape to rasterize.
+ * @param xBound The width of the area to clip the scanlines to.
+ * @param yBound The height of the area to clip the scanlines to.
+ * @param lines The vector to write the scanlines to.
+ */
+void rasterize(const geometrize::Shape& s, std::int32_t xBound, std::int32_t yBound, std::vector<geometrize::Scanline>& lines);
+void rasterize(const geometrize::Circle& s, std::int32_t xBound, std::int32_t yBound, std::vector<geometrize::Scanline>& lines);
+void rasterize(const geometrize::Ellipse& s, std::int32_t xBound, std::int32_t yBound, std::vector<geometrize::Scanline>& lines);
+void rasterize(const geometrize::Line& s, std::int32_t xBound, std::int32_t yBound, std::vector<geometrize::Scanline>& lines);
+void rasterize(const geometrize::Polyline& s, std::int32_t xBound, std::int32_t yBound, std::vector<geometrize::Scanline>& lines);
+void rasterize(const geometrize::QuadraticBezier& s, std::int32_t xBound, std::int32_t yBound, std::vector<geometrize::Scanline>& lines);
+void rasterize(const geometrize::Rectangle& s, std::int32_t xBound, std::int32_t yBound, std::vector<geometrize::Scanline>& lines);
+void rasterize(const geometrize::RotatedEllipse& s, std::int32_t xBound, std::int32_t yBound, std::vector<geometrize::Scanline>& lines);
+void rasterize(const geometrize::RotatedRectangle& s, std::int32_t xBound, std::int32_t yBound, std::vector<geometrize::Scanline>& lines);
+void rasterize(const geometrize::Triangle& s, std::int32_t xBound, std::int32_t yBound, std::vector<geometrize::Scanline>& lines);
+
 /**
  * @brief scanlinesOverlap Returns true if any of the scanlines from the first vector overlap the second
  * @param first First collection of scanlines.
@@ -99,6 +146,13 @@ bool scanlinesOverlap(const std::vector<geometrize::Scanline>& first, const std:
  */
 bool scanlinesContain(const std::vector<geometrize::Scanline>& first, const std::vector<geometrize::Scanline>& second);
 
+/**
+ * @brief scanlinesFormRectangle Returns true if the scanlines cover an axis-aligned rectangle: one scanline per row on consecutive rows in increasing order, all with the same x-coordinates.
+ * @param lines The scanlines.
+ * @return True if the scanlines are a non-empty rectangle, else false.
+ */
+bool scanlinesFormRectangle(const std::vector<geometrize::Scanline>& lines);
+
 bool shapesOverlap(const geometrize::Shape& a, const geometrize::Shape& b, std::int32_t xBound, std::int32_t yBound);
 bool shapeContains(const geometrize::Shape& container, const geometrize::Shape& containee, std::int32_t xBound, std::int32_t yBound);
 
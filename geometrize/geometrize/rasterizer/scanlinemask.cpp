@@ -0,0 +1,93 @@
+#include "scanlinemask.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "scanline.h"
+
+namespace
+{
+
+/**
+ * @brief forEachSpanWord Calls a function with each word of a row bitset that a scanline covers, along with the bits of the word it covers.
+ * @param row The bitset of the row the scanline is on.
+ * @param line The scanline, which must not be empty.
+ * @param f The function to call, returns false to stop.
+ */
+template<typename WordT, typename Function>
+void forEachSpanWord(WordT* const row, const geometrize::Scanline& line, Function f)
+{
+    const std::size_t first{static_cast<std::size_t>(line.x1) / 64U};
+    const std::size_t last{static_cast<std::size_t>(line.x2) / 64U};
+    const std::uint64_t firstBits{~UINT64_C(0) << (static_cast<std::uint32_t>(line.x1) % 64U)};
+    const std::uint64_t lastBits{~UINT64_C(0) >> (63U - static_cast<std::uint32_t>(line.x2) % 64U)};
+    for(std::size_t word = first; word <= last; word++) {
+        const std::uint64_t bits{(word == first ? firstBits : ~UINT64_C(0)) & (word == last ? lastBits : ~UINT64_C(0))};
+        if(!f(row[word], bits)) {
+            return;
+        }
+    }
+}
+
+}
+
+namespace geometrize
+{
+
+ScanlineMask::ScanlineMask(const std::uint32_t width, const std::uint32_t height) :
+    m_width{width}, m_height{height}, m_wordsPerRow{(static_cast<std::size_t>(width) + 63U) / 64U}, m_bits(m_wordsPerRow * height, 0U)
+{}
+
+bool ScanlineMask::overlaps(const std::vector<geometrize::Scanline>& lines) const
+{
+    bool overlap{false};
+    for(const geometrize::Scanline& line : lines) {
+        if(line.x2 < line.x1) {
+            continue;
+        }
+        assert(line.y >= 0 && static_cast<std::uint32_t>(line.y) < m_height);
+        assert(line.x1 >= 0 && static_cast<std::uint32_t>(line.x2) < m_width);
+        forEachSpanWord(m_bits.data() + static_cast<std::size_t>(line.y) * m_wordsPerRow, line, [&overlap](const std::uint64_t word, const std::uint64_t bits) {
+            overlap = (word & bits) != 0;
+            return !overlap;
+        });
+        if(overlap) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ScanlineMask::add(const std::vector<geometrize::Scanline>& lines)
+{
+    for(const geometrize::Scanline& line : lines) {
+        if(line.x2 < line.x1) {
+            continue;
+        }
+        assert(line.y >= 0 && static_cast<std::uint32_t>(line.y) < m_height);
+        assert(line.x1 >= 0 && static_cast<std::uint32_t>(line.x2) < m_width);
+        forEachSpanWord(m_bits.data() + static_cast<std::size_t>(line.y) * m_wordsPerRow, line, [](std::uint64_t& word, const std::uint64_t bits) {
+            word |= bits;
+            return true;
+        });
+    }
+}
+
+void ScanlineMask::remove(const std::vector<geometrize::Scanline>& lines)
+{
+    for(const geometrize::Scanline& line : lines) {
+        if(line.x2 < line.x1) {
+            continue;
+        }
+        assert(line.y >= 0 && static_cast<std::uint32_t>(line.y) < m_height);
+        assert(line.x1 >= 0 && static_cast<std::uint32_t>(line.x2) < m_width);
+        forEachSpanWord(m_bits.data() + static_cast<std::size_t>(line.y) * m_wordsPerRow, line, [](std::uint64_t& word, const std::uint64_t bits) {
+            word &= ~bits;
+            return true;
+        });
+    }
+}
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "scanline.h"
+
+namespace geometrize
+{
+
+/**
+ * @brief The ScanlineMask class records which pixels of an area are covered by some scanlines, one bit per pixel in per-row bitsets.
+ * Testing or marking scanlines costs a word per 64 pixels they cover, no matter how many scanlines have been marked already.
+ * @author Sam Twidale (https://samcodes.co.uk/)
+ */
+class ScanlineMask
+{
+public:
+    /**
+     * @brief ScanlineMask Creates a new mask with no pixels covered.
+     * @param width The width of the area.
+     * @param height The height of the area.
+     */
+    ScanlineMask(std::uint32_t width, std::uint32_t height);
+
+    ~ScanlineMask() = default;
+    ScanlineMask& operator=(const geometrize::ScanlineMask&) = default;
+    ScanlineMask(const geometrize::ScanlineMask&) = default;
+
+    /**
+     * @brief overlaps Checks whether the scanlines cover any pixel that is covered in the mask.
+     * @param lines The scanlines to check, these must lie within the area.
+     * @return True if the scanlines share at least one pixel with the mask, else false.
+     */
+    bool overlaps(const std::vector<geometrize::Scanline>& lines) const;
+
+    /**
+     * @brief add Marks the pixels covered by the scanlines as covered.
+     * @param lines The scanlines to add, these must lie within the area.
+     */
+    void add(const std::vector<geometrize::Scanline>& lines);
+
+    /**
+     * @brief remove Marks the pixels covered by the scanlines as not covered, e.g. to clear the mask after adding them.
+     * @param lines The scanlines to remove, these must lie within the area.
+     */
+    void remove(const std::vector<geometrize::Scanline>& lines);
+
+private:
+    std::uint32_t m_width; ///< The width of the area.
+    std::uint32_t m_height; ///< The height of the area.
+    std::size_t m_wordsPerRow; ///< The number of 64-bit words in the bitset for each row.
+    std::vector<std::uint64_t> m_bits; ///< The bitsets for the rows, bit x % 64 of word x / 64 of a row is set if pixel x is covered.
+};
+
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+#include "../commonutil.h"
+#include "../shape/circle.h"
+#include "../shape/ellipse.h"
+#include "../shape/rectangle.h"
+#include "../shape/rotatedellipse.h"
+
+namespace geometrize
+{
+
+/**
+ * Push-style rasterizers for the shapes whose rows can be worked out one at a time. Rather than returning a vector of scanlines, these call
+ * a visitor with the y-coordinate and the inclusive x-coordinates of each span, in order of increasing y. The spans are clipped to the bounds,
+ * and are the same as the scanlines geometrize::rasterize gives for the shape (which is built on these).
+ * Being templates, the visitor can be inlined, so e.g. an energy function can consume the spans as they are made without storing them.
+ */
+
+/**
+ * @brief forEachSpan Calls a visitor for each span of a circle.
+ * @param s The circle.
+ * @param xBound The width of the area to clip to.
+ * @param yBound The height of the area to clip to.
+ * @param visit The visitor, called with the y, x1 and x2 coordinates of each span.
+ */
+template<typename Visitor>
+void forEachSpan(const geometrize::Circle& s, const std::int32_t xBound, const std::int32_t yBound, Visitor visit)
+{
+    const std::int32_t r{static_cast<std::int32_t>(s.m_r)};
+    const std::int32_t cx{static_cast<std::int32_t>(s.m_x)};
+    const std::int32_t cy{static_cast<std::int32_t>(s.m_y)};
+
+    // The half width w of the row dy from the middle is the largest with w^2 + dy^2 <= r^2, it grows down to the middle row and shrinks after it
+    std::int32_t w{0};
+    for(std::int32_t dy = -r; dy <= r; dy++) {
+        if(dy <= 0) {
+            while((w + 1) * (w + 1) + dy * dy <= r * r) {
+                w++;
+            }
+        } else {
+            while(w * w + dy * dy > r * r) {
+                w--;
+            }
+        }
+        const std::int32_t y{cy + dy};
+        if(y >= 0 && y < yBound) {
+            visit(y, geometrize::commonutil::clamp(cx - w, 0, xBound - 1), geometrize::commonutil::clamp(cx + w, 0, xBound - 1));
+        }
+    }
+}
+
+/**
+ * @brief forEachSpan Calls a visitor for each span of an ellipse.
+ * @param s The ellipse.
+ * @param xBound The width of the area to clip to.
+ * @param yBound The height of the area to clip to.
+ * @param visit The visitor, called with the y, x1 and x2 coordinates of each span.
+ */
+template<typename Visitor>
+void forEachSpan(const geometrize::Ellipse& s, const std::int32_t xBound, const std::int32_t yBound, Visitor visit)
+{
+    // The rows are those within dy < ry of the middle row
+    const std::int32_t rows{s.m_ry > 0 ? static_cast<std::int32_t>(std::ceil(s.m_ry)) : 0};
+    if(rows == 0) {
+        return;
+    }
+    const std::int32_t cx{static_cast<std::int32_t>(s.m_x)};
+    const std::int32_t cy{static_cast<std::int32_t>(s.m_y)};
+    const std::int32_t y1{(std::max)(cy - rows + 1, 0)};
+    const std::int32_t y2{(std::min)(cy + rows - 1, yBound - 1)};
+
+    const float aspect{static_cast<float>(s.m_rx) / static_cast<float>(s.m_ry)};
+    for(std::int32_t y = y1; y <= y2; y++) {
+        const std::int32_t dy{std::abs(y - cy)};
+        const std::int32_t v{static_cast<std::int32_t>(std::sqrt(s.m_ry * s.m_ry - dy * dy) * aspect)};
+        const std::int32_t x1{(std::max)(cx - v, 0)};
+        const std::int32_t x2{(std::min)(cx + v, xBound - 1)};
+        if(x1 <= x2) {
+            visit(y, x1, x2);
+        }
+    }
+}
+
+/**
+ * @brief forEachSpan Calls a visitor for each span of a rectangle.
+ * @param s The rectangle.
+ * @param xBound The width of the area to clip to.
+ * @param yBound The height of the area to clip to.
+ * @param visit The visitor, called with the y, x1 and x2 coordinates of each span.
+ */
+template<typename Visitor>
+void forEachSpan(const geometrize::Rectangle& s, const std::int32_t xBound, const std::int32_t yBound, Visitor visit)
+{
+    const std::int32_t x1{geometrize::commonutil::clamp(static_cast<std::int32_t>((std::fmin)(s.m_x1, s.m_x2)), 0, xBound - 1)};
+    const std::int32_t x2{geometrize::commonutil::clamp(static_cast<std::int32_t>((std::fmax)(s.m_x1, s.m_x2)), 0, xBound - 1)};
+    const std::int32_t y1{(std::max)(static_cast<std::int32_t>((std::fmin)(s.m_y1, s.m_y2)), 0)};
+    const std::int32_t y2{(std::min)(static_cast<std::int32_t>((std::fmax)(s.m_y1, s.m_y2)), yBound)};
+    for(std::int32_t y = y1; y < y2; y++) {
+        visit(y, x1, x2);
+    }
+}
+
+/**
+ * @brief forEachSpan Calls a visitor for each span of a rotated ellipse. Each row's span is solved for exactly, and covers the pixels whose
+ * centres are inside the ellipse, or the nearest pixel if it is too narrow for any, so thin ellipses don't break up.
+ * @param s The rotated ellipse.
+ * @param xBound The width of the area to clip to.
+ * @param yBound The height of the area to clip to.
+ * @param visit The visitor, called with the y, x1 and x2 coordinates of each span.
+ */
+template<typename Visitor>
+void forEachSpan(const geometrize::RotatedEllipse& s, const std::int32_t xBound, const std::int32_t yBound, Visitor visit)
+{
+    // A point (dx, dy) from the centre is inside the ellipse if a * dx^2 + b * dx * dy + c * dy^2 <= 1
+    // For each row that's a quadratic in dx, whose roots are the ends of the row's span
+    const double rads{static_cast<double>(s.m_angle) * (3.14159265358979323846 / 180.0)};
+    const double co{std::cos(rads)};
+    const double si{std::sin(rads)};
+    const double rx2{static_cast<double>(s.m_rx) * static_cast<double>(s.m_rx)};
+    const double ry2{static_cast<double>(s.m_ry) * static_cast<double>(s.m_ry)};
+    if(rx2 <= 0.0 || ry2 <= 0.0) {
+        return;
+    }
+    const double a{co * co / rx2 + si * si / ry2};
+    const double b{2.0 * co * si * (1.0 / rx2 - 1.0 / ry2)};
+    const double c{si * si / rx2 + co * co / ry2};
+
+    // The half height of the ellipse's bounding box
+    const double cx{static_cast<double>(s.m_x)};
+    const double cy{static_cast<double>(s.m_y)};
+    const double halfHeight{std::sqrt(rx2 * si * si + ry2 * co * co)};
+    const std::int32_t y1{(std::max)(static_cast<std::int32_t>(std::ceil(cy - halfHeight)), 0)};
+    const std::int32_t y2{(std::min)(static_cast<std::int32_t>(std::floor(cy + halfHeight)), yBound - 1)};
+
+    for(std::int32_t y = y1; y <= y2; y++) {
+        const double dy{static_cast<double>(y) - cy};
+        const double discriminant{(std::max)(b * b * dy * dy - 4.0 * a * (c * dy * dy - 1.0), 0.0)};
+        const double root{std::sqrt(discriminant)};
+
+        const double left{cx + (-b * dy - root) / (2.0 * a)};
+        const double right{cx + (-b * dy + root) / (2.0 * a)};
+        std::int32_t x1{static_cast<std::int32_t>(std::ceil(left))};
+        std::int32_t x2{static_cast<std::int32_t>(std::floor(right))};
+        if(x1 > x2) {
+            x1 = x2 = static_cast<std::int32_t>(std::floor((left + right) / 2.0 + 0.5));
+        }
+        if(x2 >= 0 && x1 < xBound) {
+            visit(y, (std::max)(x1, 0), (std::min)(x2, xBound - 1));
+        }
+    }
+}
+
+}
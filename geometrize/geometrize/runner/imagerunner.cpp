@@ -1,14 +1,21 @@
 #include "imagerunner.h"
 
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "../bitmap/bitmap.h"
+#include "../bitmap/rgba.h"
+#include "../commonutil.h"
 #include "../core.h"
 #include "../model.h"
+#include "../rasterizer/rasterizer.h"
+#include "../rasterizer/scanline.h"
 #include "../shape/shape.h"
 #include "../shape/shapefactory.h"
+#include "../shape/shapemutator.h"
 #include "../shape/shapetypes.h"
 #include "imagerunneroptions.h"
 
@@ -26,15 +33,24 @@ public:
 
     std::vector<geometrize::ShapeResult> step(const geometrize::ImageRunnerOptions& options, std::function<std::shared_ptr<geometrize::Shape>()> shapeCreator, geometrize::core::EnergyFunction energyFunction)
     {
-        const std::int32_t w = m_model.getTarget().getWidth();
-        const std::int32_t h = m_model.getTarget().getHeight();
         const geometrize::ShapeTypes types = options.shapeTypes;
 
+        if(m_stepCount++ < options.coarseSteps && options.coarseScale > 1) {
+            return coarseStep(options, energyFunction);
+        }
+        m_coarseModel.reset(); // Done with the coarse level, if there was one
+
+        configureModel(m_model, options);
+
+        // Tiled steps create the shapes for each tile themselves, so a custom shape creator gets an untiled step
+        if(options.tileSize > 0 && !shapeCreator) {
+            return m_model.stepTiled(types, options.alpha, options.shapeCount, options.maxShapeMutations, options.maxThreads, options.tileSize, options.tileHaloSize, energyFunction);
+        }
+
         if(!shapeCreator) {
-            shapeCreator = geometrize::createDefaultShapeCreator(types, w, h);
+            return m_model.step(createShapeSpace(m_model, options), options.alpha, options.shapeCount, options.maxShapeMutations, options.maxThreads, energyFunction);
         }
 
-        m_model.setSeed(options.seed);
         return m_model.step(shapeCreator, options.alpha, options.shapeCount, options.maxShapeMutations, options.maxThreads, energyFunction);
     }
 
@@ -64,7 +80,84 @@ public:
     }
 
 private:
+    std::vector<geometrize::ShapeResult> coarseStep(const geometrize::ImageRunnerOptions& options, const geometrize::core::EnergyFunction& energyFunction)
+    {
+        // Start the coarse level from the current state of the full resolution model
+        if(!m_coarseModel || m_coarseScale != options.coarseScale) {
+            m_coarseScale = options.coarseScale;
+            m_coarseModel.reset(new geometrize::Model(
+                    geometrize::commonutil::downsampleImage(m_model.getTarget(), m_coarseScale),
+                    geometrize::commonutil::downsampleImage(m_model.getCurrent(), m_coarseScale)));
+        }
+
+        configureModel(*m_coarseModel, options);
+        const std::vector<geometrize::ShapeResult> coarseResults{m_coarseModel->step(createShapeSpace(*m_coarseModel, options),
+                options.alpha, options.shapeCount, options.maxShapeMutations, options.maxThreads, energyFunction)};
+
+        // Replay the shapes at full resolution, with the colors that best fit the full resolution pixels they cover
+        // Like the shapes found by full resolution steps, a shape is only kept if it improves the full resolution image - lifting and downsampling
+        // mean some don't. The coarse model keeps the shapes it found either way, so its image is allowed to drift from the full resolution one
+        // until the coarse steps are done. It is only a guide to where shapes are needed, and is discarded after the last coarse step
+        std::vector<geometrize::ShapeResult> results;
+        for(const geometrize::ShapeResult& coarseResult : coarseResults) {
+            const std::shared_ptr<geometrize::Shape> shape{liftShape(*coarseResult.shape, m_coarseScale, m_model.getWidth(), m_model.getHeight())};
+            const std::vector<geometrize::Scanline> lines{shape->rasterize(*shape)};
+            if(lines.empty()) {
+                continue;
+            }
+            const geometrize::rgba color{geometrize::core::computeColor(m_model.getTarget(), m_model.getCurrent(), lines, options.alpha)};
+            const geometrize::ShapeResult result{m_model.drawShapeIfImproved(shape, color)};
+            if(result.shape) {
+                results.push_back(result);
+            }
+        }
+        return results;
+    }
+
+    static void configureModel(geometrize::Model& model, const geometrize::ImageRunnerOptions& options)
+    {
+        model.setSeed(options.seed);
+        model.setMomentTablesEnabled(options.useMomentTables, options.exactMomentEnergy);
+        model.setSummedAreaTablesEnabled(options.useSummedAreaTables);
+        model.setCandidatePartitioningEnabled(options.partitionCandidates, options.hillClimbCount);
+        model.setMaxShapesPerStep(options.maxShapesPerStep);
+        model.setErrorMapEnabled(options.errorWeightedPlacement, options.errorMapCellSize);
+        model.setScreeningEnabled(options.screeningRatio < 1.0f, options.screeningRatio, options.screeningScale, options.auditScreening);
+    }
+
+    static geometrize::ShapeSpace createShapeSpace(const geometrize::Model& model, const geometrize::ImageRunnerOptions& options)
+    {
+        return geometrize::createShapeSpace(options.shapeTypes, model.getWidth(), model.getHeight(), options.errorWeightedPlacement ? model.getErrorMap() : nullptr);
+    }
+
+    /**
+     * @brief liftShape Makes a full resolution copy of a shape found on a downsampled image.
+     * @param shape The shape, in the coordinates of the downsampled image.
+     * @param factor The factor the image was downsampled by.
+     * @param w The width of the full resolution image.
+     * @param h The height of the full resolution image.
+     * @return The shape scaled up to full resolution, set up to mutate and rasterize within the full resolution bounds.
+     */
+    static std::shared_ptr<geometrize::Shape> liftShape(const geometrize::Shape& shape, const std::uint32_t factor, const std::int32_t w, const std::int32_t h)
+    {
+        const std::shared_ptr<geometrize::Shape> lifted{shape.clone()};
+        const float f{static_cast<float>(factor)};
+
+        // Grow the shape about its centre, then move the centre to the middle of the block of pixels the downsampled pixel came from
+        const std::pair<float, float> centre{geometrize::getCentre(*lifted)};
+        geometrize::scale(*lifted, f);
+        geometrize::translate(*lifted, centre.first * (f - 1.0f) + (f - 1.0f) / 2.0f, centre.second * (f - 1.0f) + (f - 1.0f) / 2.0f);
+
+        lifted->setup = [w, h](geometrize::Shape& s) { geometrize::setup(s, w, h); };
+        lifted->mutate = [w, h](geometrize::Shape& s) { geometrize::mutate(s, w, h); };
+        lifted->rasterize = [w, h](const geometrize::Shape& s) { return geometrize::rasterize(s, w, h); };
+        return lifted;
+    }
+
     geometrize::Model m_model; ///< The model for the primitive optimization/fitting algorithm.
+    std::unique_ptr<geometrize::Model> m_coarseModel; ///< The model for the downsampled target during the first steps, null unless in use. Starts from the full resolution image, but then keeps every shape it finds, including those not kept at full resolution.
+    std::uint32_t m_coarseScale{0}; ///< The factor the coarse model's target was downsampled by.
+    std::uint32_t m_stepCount{0}; ///< The number of times the runner was stepped.
 };
 
 ImageRunner::ImageRunner(const geometrize::Bitmap& targetBitmap) :
@@ -19,7 +19,22 @@ public:
     std::uint32_t shapeCount = 50U; ///< The number of candidate shapes that will be tried per model step.
     std::uint32_t maxShapeMutations = 100U; ///< The maximum number of times each candidate shape will be modified to attempt to find a better fit.
     std::uint32_t seed = 9001U; ///< The seed for the random number generators used by the image runner.
-    std::uint32_t maxThreads = 0; ///< The maximum number of separate threads for the implementation to use. 0 lets the implementation choose a reasonable number.
+    std::uint32_t maxShapesPerStep = 1U; ///< The maximum number of non-overlapping shapes the image runner may add per step, chosen from the best states found by the threads.
+    std::uint32_t maxThreads = 0; ///< The maximum number of separate threads for the implementation to use. 0 lets the implementation choose a reasonable number, without making the results depend on the number of cores.
+    bool useMomentTables = false; ///< Whether to score candidate shapes with prefix-sum moment tables, which is much faster for large shapes but only approximates the default energy function.
+    bool exactMomentEnergy = false; ///< With useMomentTables, use the tables to speed up the exact energy calculation (shape colors and early rejection of hopeless candidates) instead of estimating it.
+    bool useSummedAreaTables = false; ///< Whether to score rectangular candidate shapes with summed-area tables, so the cost doesn't grow with their size. Like the moment tables this only approximates the default energy function.
+    bool partitionCandidates = false; ///< Whether to split the shapeCount candidates between threads rather than have each thread try shapeCount candidates of its own, so more threads make steps faster instead of searching more.
+    std::uint32_t hillClimbCount = 4U; ///< With partitionCandidates, the number of best candidates that are hill climbed (in parallel) each step.
+    float screeningRatio = 1.0f; ///< Below 1, the random candidates are first ranked on a downsampled copy of the images and only this fraction of them are scored at full resolution. See Model::getScreeningStats for how often the screen gets it wrong.
+    std::uint32_t screeningScale = 2U; ///< With screeningRatio below 1, the factor the images are downsampled by for screening, e.g. 2 for half or 4 for quarter resolution.
+    bool auditScreening = false; ///< With screeningRatio below 1, also score the candidates that fail the screen at full resolution, to count how often the best one is dropped. Costs as much as not screening.
+    bool errorWeightedPlacement = false; ///< Whether the default shape creator places new shapes in proportion to a map of the remaining error, rather than uniformly. Ignored if a custom shape creator is used.
+    std::uint32_t errorMapCellSize = 16U; ///< With errorWeightedPlacement, the width and height of the cells of the error map.
+    std::uint32_t coarseSteps = 0U; ///< The number of steps to run on a downsampled copy of the target before switching to full resolution, the shapes found are scaled up and added to the full resolution image where they improve it. Custom shape creators are only used at full resolution.
+    std::uint32_t coarseScale = 4U; ///< With coarseSteps, the factor the target is downsampled by for the coarse steps, so they work on 1/coarseScale^2 of the pixels.
+    std::uint32_t tileSize = 0U; ///< When non-zero, each step covers the image in tiles of this size with a shape attempted for every tile, for very large images. Steps with a custom shape creator are not tiled.
+    std::uint32_t tileHaloSize = 32U; ///< With tileSize, how far outside its tile a shape may reach, larger values are clamped to half of tileSize.
 };
 
 }
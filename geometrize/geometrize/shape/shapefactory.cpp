@@ -1,8 +1,11 @@
 #include "shapefactory.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "shape.h"
 #include "circle.h"
@@ -13,83 +16,152 @@
 #include "rectangle.h"
 #include "rotatedellipse.h"
 #include "rotatedrectangle.h"
+#include "shapespace.h"
 #include "shapetypes.h"
+#include "shapevariant.h"
 #include "triangle.h"
 #include "shapemutator.h"
+#include "../bitmap/errormap.h"
 #include "../commonutil.h"
 #include "../rasterizer/rasterizer.h"
+#include "../rasterizer/scanline.h"
 
-namespace geometrize
+namespace
 {
 
-std::function<std::shared_ptr<geometrize::Shape>()> createDefaultShapeCreator(const geometrize::ShapeTypes types, const std::int32_t w, const std::int32_t h)
+/**
+ * @brief pickShapeType Picks a random shape type from the types supplied, or from all types if none are supplied.
+ * @param types The types of shape to possibly pick.
+ * @return The picked type.
+ */
+geometrize::ShapeTypes pickShapeType(const geometrize::ShapeTypes types)
 {
-    auto f = [types, w, h]() {
-        std::shared_ptr<geometrize::Shape> s = geometrize::randomShapeOf(types);
-
-        switch(s->getType()) {
-        case geometrize::ShapeTypes::RECTANGLE: {
-            s->setup = [w, h](geometrize::Shape& s) { return geometrize::setup(static_cast<geometrize::Rectangle&>(s), w, h); };
-            s->mutate = [w, h](geometrize::Shape& s) { geometrize::mutate(static_cast<geometrize::Rectangle&>(s), w, h); };
-            s->rasterize = [w, h](const geometrize::Shape& s) { return geometrize::rasterize(static_cast<const geometrize::Rectangle&>(s), w, h); };
-            break;
-        }
-        case geometrize::ShapeTypes::ROTATED_RECTANGLE: {
-            s->setup = [w, h](geometrize::Shape& s) { return geometrize::setup(static_cast<geometrize::RotatedRectangle&>(s), w, h); };
-            s->mutate = [w, h](geometrize::Shape& s) { geometrize::mutate(static_cast<geometrize::RotatedRectangle&>(s), w, h); };
-            s->rasterize = [w, h](const geometrize::Shape& s) { return geometrize::rasterize(static_cast<const geometrize::RotatedRectangle&>(s), w, h); };
-            break;
-        }
-        case geometrize::ShapeTypes::TRIANGLE: {
-            s->setup = [w, h](geometrize::Shape& s) { return geometrize::setup(static_cast<geometrize::Triangle&>(s), w, h); };
-            s->mutate = [w, h](geometrize::Shape& s) { geometrize::mutate(static_cast<geometrize::Triangle&>(s), w, h); };
-            s->rasterize = [w, h](const geometrize::Shape& s) { return geometrize::rasterize(static_cast<const geometrize::Triangle&>(s), w, h); };
-            break;
-        }
-        case geometrize::ShapeTypes::ELLIPSE: {
-            s->setup = [w, h](geometrize::Shape& s) { return geometrize::setup(static_cast<geometrize::Ellipse&>(s), w, h); };
-            s->mutate = [w, h](geometrize::Shape& s) { geometrize::mutate(static_cast<geometrize::Ellipse&>(s), w, h); };
-            s->rasterize = [w, h](const geometrize::Shape& s) { return geometrize::rasterize(static_cast<const geometrize::Ellipse&>(s), w, h); };
-            break;
-        }
-        case geometrize::ShapeTypes::ROTATED_ELLIPSE: {
-            s->setup = [w, h](geometrize::Shape& s) { return geometrize::setup(static_cast<geometrize::RotatedEllipse&>(s), w, h); };
-            s->mutate = [w, h](geometrize::Shape& s) { geometrize::mutate(static_cast<geometrize::RotatedEllipse&>(s), w, h); };
-            s->rasterize = [w, h](const geometrize::Shape& s) { return geometrize::rasterize(static_cast<const geometrize::RotatedEllipse&>(s), w, h); };
-            break;
-        }
-        case geometrize::ShapeTypes::CIRCLE: {
-            s->setup = [w, h](geometrize::Shape& s) { return geometrize::setup(static_cast<geometrize::Circle&>(s), w, h); };
-            s->mutate = [w, h](geometrize::Shape& s) { geometrize::mutate(static_cast<geometrize::Circle&>(s), w, h); };
-            s->rasterize = [w, h](const geometrize::Shape& s) { return geometrize::rasterize(static_cast<const geometrize::Circle&>(s), w, h); };
-            break;
-        }
-        case geometrize::ShapeTypes::LINE: {
-            s->setup = [w, h](geometrize::Shape& s) { return geometrize::setup(static_cast<geometrize::Line&>(s), w, h); };
-            s->mutate = [w, h](geometrize::Shape& s) { geometrize::mutate(static_cast<geometrize::Line&>(s), w, h); };
-            s->rasterize = [w, h](const geometrize::Shape& s) { return geometrize::rasterize(static_cast<const geometrize::Line&>(s), w, h); };
-            break;
-        }
-        case geometrize::ShapeTypes::QUADRATIC_BEZIER: {
-            s->setup = [w, h](geometrize::Shape& s) { return geometrize::setup(static_cast<geometrize::QuadraticBezier&>(s), w, h); };
-            s->mutate = [w, h](geometrize::Shape& s) { geometrize::mutate(static_cast<geometrize::QuadraticBezier&>(s), w, h); };
-            s->rasterize = [w, h](const geometrize::Shape& s) { return geometrize::rasterize(static_cast<const geometrize::QuadraticBezier&>(s), w, h); };
-            break;
-        }
-        case geometrize::ShapeTypes::POLYLINE: {
-            s->setup = [w, h](geometrize::Shape& s) { return geometrize::setup(static_cast<geometrize::Polyline&>(s), w, h); };
-            s->mutate = [w, h](geometrize::Shape& s) { geometrize::mutate(static_cast<geometrize::Polyline&>(s), w, h); };
-            s->rasterize = [w, h](const geometrize::Shape& s) { return geometrize::rasterize(static_cast<const geometrize::Polyline&>(s), w, h); };
-            break;
+    std::int32_t count{0};
+    for(const geometrize::ShapeTypes type : geometrize::allShapes) {
+        if((type & types) == type) {
+            count++;
         }
-        default:
-            assert(0 && "Bad shape type");
+    }
+
+    if(count == 0) {
+        return geometrize::allShapes[geometrize::commonutil::randomRange(0, static_cast<std::int32_t>(geometrize::allShapes.size()) - 1)];
+    }
+
+    std::int32_t index{geometrize::commonutil::randomRange(0, count - 1)};
+    for(const geometrize::ShapeTypes type : geometrize::allShapes) {
+        if((type & types) == type && index-- == 0) {
+            return type;
         }
+    }
+    assert(0 && "Failed to pick a shape type");
+    return geometrize::ShapeTypes::RECTANGLE;
+}
 
+void bindFunctions(geometrize::Shape& s, const geometrize::ShapeSpace& space)
+{
+    s.setup = [space](geometrize::Shape& s) { geometrize::setupInSpace(s, space); };
+    s.mutate = [space](geometrize::Shape& s) { geometrize::mutateInSpace(s, space); };
+    s.rasterize = [space](const geometrize::Shape& s) { return geometrize::rasterizeInSpace(s, space); };
+}
+
+std::function<std::shared_ptr<geometrize::Shape>()> createShapeCreator(const geometrize::ShapeSpace& space)
+{
+    return [space]() {
+        std::shared_ptr<geometrize::Shape> s{geometrize::randomShapeOf(space.types)};
+        bindFunctions(*s, space);
         return s;
     };
+}
+
+}
+
+namespace geometrize
+{
+
+geometrize::ShapeSpace createShapeSpace(const geometrize::ShapeTypes types, const std::int32_t w, const std::int32_t h, const std::shared_ptr<const geometrize::ErrorMap> errorMap)
+{
+    return geometrize::ShapeSpace{types, 0, 0, w, h, errorMap};
+}
+
+geometrize::ShapeVariant createShape(const geometrize::ShapeSpace& space)
+{
+    geometrize::ShapeVariant shape(pickShapeType(space.types));
+    geometrize::setupInSpace(shape.get(), space);
+    return shape;
+}
+
+void createShape(const geometrize::ShapeSpace& space, geometrize::ShapeVariant& shape)
+{
+    const geometrize::ShapeTypes type{pickShapeType(space.types)};
+    if(shape.isEmpty() || shape.isCustom() || shape.getType() != type) {
+        shape = geometrize::ShapeVariant(type);
+    } else if(type == geometrize::ShapeTypes::POLYLINE) {
+        static_cast<geometrize::Polyline&>(shape.get()).m_points.clear(); // Setup adds the points
+    }
+    geometrize::setupInSpace(shape.get(), space);
+}
+
+geometrize::ShapeVariant createShape(const std::function<std::shared_ptr<geometrize::Shape>()>& shapeCreator)
+{
+    const std::shared_ptr<geometrize::Shape> s{shapeCreator()};
+    s->setup(*s);
+    return geometrize::ShapeVariant(s);
+}
+
+void mutate(geometrize::ShapeVariant& shape, const geometrize::ShapeSpace& space)
+{
+    geometrize::Shape& s{shape.get()};
+    if(shape.isCustom()) {
+        s.mutate(s);
+        return;
+    }
+    geometrize::mutateInSpace(s, space);
+}
+
+std::vector<geometrize::Scanline> rasterize(const geometrize::ShapeVariant& shape, const geometrize::ShapeSpace& space)
+{
+    const geometrize::Shape& s{shape.get()};
+    if(shape.isCustom()) {
+        return s.rasterize(s);
+    }
+    return geometrize::rasterizeInSpace(s, space);
+}
+
+void rasterize(const geometrize::ShapeVariant& shape, const geometrize::ShapeSpace& space, std::vector<geometrize::Scanline>& lines)
+{
+    const geometrize::Shape& s{shape.get()};
+    if(shape.isCustom()) {
+        lines = s.rasterize(s);
+        return;
+    }
+    geometrize::rasterizeInSpace(s, space, lines);
+}
 
-    return f;
+std::shared_ptr<geometrize::Shape> createShape(const geometrize::ShapeVariant& shape, const geometrize::ShapeSpace& space)
+{
+    if(shape.isCustom()) {
+        return shape.getCustom();
+    }
+    const std::shared_ptr<geometrize::Shape> s{shape.get().clone()};
+    bindFunctions(*s, space);
+    return s;
+}
+
+std::function<std::shared_ptr<geometrize::Shape>()> createDefaultShapeCreator(const geometrize::ShapeTypes types, const std::int32_t w, const std::int32_t h)
+{
+    return createShapeCreator(geometrize::createShapeSpace(types, w, h));
+}
+
+std::function<std::shared_ptr<geometrize::Shape>()> createDefaultShapeCreator(const geometrize::ShapeTypes types, const std::int32_t xMin, const std::int32_t yMin, const std::int32_t xMax, const std::int32_t yMax)
+{
+    assert(xMin < xMax && yMin < yMax);
+    return createShapeCreator(geometrize::ShapeSpace{types, xMin, yMin, xMax, yMax, nullptr});
+}
+
+std::function<std::shared_ptr<geometrize::Shape>()> createErrorWeightedShapeCreator(const geometrize::ShapeTypes types, const std::int32_t w, const std::int32_t h, const std::shared_ptr<const geometrize::ErrorMap> errorMap)
+{
+    assert(errorMap);
+    return createShapeCreator(geometrize::createShapeSpace(types, w, h, errorMap));
 }
 
 std::shared_ptr<geometrize::Shape> create(const geometrize::ShapeTypes t)
@@ -128,18 +200,7 @@ std::shared_ptr<geometrize::Shape> randomShape()
 
 std::shared_ptr<geometrize::Shape> randomShapeOf(const ShapeTypes types)
 {
-    std::vector<ShapeTypes> typeVector;
-    for(const ShapeTypes type : geometrize::allShapes) {
-        if((type & types) == type) {
-            typeVector.push_back(type);
-        }
-    }
-
-    if(typeVector.size() == 0) {
-        return randomShape(); // If there are no types specified, create one randomly
-    }
-
-    return create(typeVector.at(commonutil::randomRange(0, static_cast<std::int32_t>(typeVector.size() - 1))));
+    return create(pickShapeType(types));
 }
 
 }
@@ -3,18 +3,87 @@
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "shape.h"
+#include "shapespace.h"
 #include "shapetypes.h"
+#include "../rasterizer/scanline.h"
 
 namespace geometrize
 {
+class ErrorMap;
 class Shape;
+class ShapeVariant;
 }
 
 namespace geometrize
 {
 
+/**
+ * @brief createShapeSpace Creates the space the default shape creator covers.
+ * @param types The types of shapes to create.
+ * @param w The max width of the shapes.
+ * @param h The max height of the shapes.
+ * @param errorMap The error map to place new shapes with, or null to place them uniformly.
+ * @return The shape space.
+ */
+geometrize::ShapeSpace createShapeSpace(geometrize::ShapeTypes types, std::int32_t w, std::int32_t h, std::shared_ptr<const geometrize::ErrorMap> errorMap = nullptr);
+
+/**
+ * @brief createShape Creates a random shape from the types of the space, and sets it up within the space.
+ * @param space The space to create the shape in.
+ * @return The new shape.
+ */
+geometrize::ShapeVariant createShape(const geometrize::ShapeSpace& space);
+
+/**
+ * @brief createShape Creates a random shape from the types of the space in an existing variant, and sets it up within the space. The same as assigning
+ * the result of the overload above, but if the variant already holds a shape of the picked type its storage is reused, so e.g. a polyline keeps its points' storage.
+ * @param space The space to create the shape in.
+ * @param shape The variant to hold the new shape.
+ */
+void createShape(const geometrize::ShapeSpace& space, geometrize::ShapeVariant& shape);
+
+/**
+ * @brief createShape Creates a shape with a shape creator and sets it up with its own setup function, keeping it as a custom shape.
+ * @param shapeCreator The shape creator, e.g. one made by createDefaultShapeCreator or a user-defined one.
+ * @return The new shape.
+ */
+geometrize::ShapeVariant createShape(const std::function<std::shared_ptr<geometrize::Shape>()>& shapeCreator);
+
+/**
+ * @brief mutate Mutates a shape within a space. Custom shapes use their own mutate function.
+ * @param shape The shape to mutate.
+ * @param space The space the shape was created in.
+ */
+void mutate(geometrize::ShapeVariant& shape, const geometrize::ShapeSpace& space);
+
+/**
+ * @brief rasterize Rasterizes a shape, clipped to a space. Custom shapes use their own rasterize function.
+ * @param shape The shape to rasterize.
+ * @param space The space the shape was created in.
+ * @return The scanlines of the shape.
+ */
+std::vector<geometrize::Scanline> rasterize(const geometrize::ShapeVariant& shape, const geometrize::ShapeSpace& space);
+
+/**
+ * @brief rasterize Rasterizes a shape clipped to a space into a vector supplied by the caller, replacing its contents.
+ * Built-in shapes allocate nothing once the vector has grown to fit them. Custom shapes use their own rasterize function.
+ * @param shape The shape to rasterize.
+ * @param space The space the shape was created in.
+ * @param lines The vector to put the scanlines of the shape in.
+ */
+void rasterize(const geometrize::ShapeVariant& shape, const geometrize::ShapeSpace& space, std::vector<geometrize::Scanline>& lines);
+
+/**
+ * @brief createShape Copies a shape onto the heap, with its setup, mutate and rasterize functions bound to a space as the matching shape creator would bind them.
+ * @param shape The shape to copy. A custom shape is returned as is.
+ * @param space The space the shape was created in.
+ * @return The shape.
+ */
+std::shared_ptr<geometrize::Shape> createShape(const geometrize::ShapeVariant& shape, const geometrize::ShapeSpace& space);
+
 /**
  * @brief createDefaultShapeCreator Creates an instance of the default shape creator object.
  * The setup, mutate and rasterize methods are bound with default methods.
@@ -25,6 +94,29 @@ namespace geometrize
  */
 std::function<std::shared_ptr<geometrize::Shape>()> createDefaultShapeCreator(geometrize::ShapeTypes types, std::int32_t w, std::int32_t h);
 
+/**
+ * @brief createDefaultShapeCreator Creates an instance of the default shape creator object, for shapes confined to a rectangular region of the image.
+ * The shapes are set up and mutated as the default shapes for a region-sized image would be, but offset to the region, and their scanlines are clipped to the region.
+ * @param types The types of shapes to create.
+ * @param xMin The left edge of the region, inclusive.
+ * @param yMin The top edge of the region, inclusive.
+ * @param xMax The right edge of the region, exclusive.
+ * @param yMax The bottom edge of the region, exclusive.
+ * @return The default shape creator for the region.
+ */
+std::function<std::shared_ptr<geometrize::Shape>()> createDefaultShapeCreator(geometrize::ShapeTypes types, std::int32_t xMin, std::int32_t yMin, std::int32_t xMax, std::int32_t yMax);
+
+/**
+ * @brief createErrorWeightedShapeCreator Creates a shape creator like the default one, except that each new shape is moved so it is centred on a point
+ * sampled from the error map, so more shapes are tried where the current image matches the target worst. Mutation is the same as for the default shapes.
+ * @param types The types of shapes to create.
+ * @param w The max width of the shapes.
+ * @param h The max height of the shapes.
+ * @param errorMap The error map to sample from, it must be kept up to date with the model (e.g. the one from geometrize::Model::getErrorMap).
+ * @return The error-weighted shape creator.
+ */
+std::function<std::shared_ptr<geometrize::Shape>()> createErrorWeightedShapeCreator(geometrize::ShapeTypes types, std::int32_t w, std::int32_t h, std::shared_ptr<const geometrize::ErrorMap> errorMap);
+
 /**
  * @brief create Creates a new shape of the specified type.
  * @param t The type of shape to create.
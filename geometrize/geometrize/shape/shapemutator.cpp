@@ -1,8 +1,12 @@
 #include "shapemutator.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <cmath>
+#include <utility>
+#include <vector>
 
 #include "circle.h"
 #include "ellipse.h"
@@ -545,30 +549,25 @@ void scale(geometrize::Line& s, const float scaleFactor)
 
 void scale(geometrize::Polyline& s, const float scaleFactor)
 {
-    std::vector<std::pair<float, float>> points;
+    const std::pair<float, float> mid = geometrize::getCentre(s);
 
-    for(std::size_t i = 0; i < s.m_points.size(); i+=2) {
-        if(i == s.m_points.size() - 1 || i == s.m_points.size()) {
-            continue;
-        }
-        const float x1 = s.m_points[i].first;
-        const float x2 = s.m_points[i + 1].first;
-        const float y1 = s.m_points[i].second;
-        const float y2 = s.m_points[i + 1].second;
-
-        const float xLen = (x1 + x2) / 2;
-        const float yLen = (y1 + y2) / 2;
-
-        points.push_back({(x1 - xLen) * scaleFactor + xLen, (y1 - yLen) * scaleFactor + yLen});
-        points.push_back({(x1 - xLen) * scaleFactor + xLen, (y2 - yLen) * scaleFactor + yLen});
+    for(std::pair<float, float>& point : s.m_points) {
+        point.first = (point.first - mid.first) * scaleFactor + mid.first;
+        point.second = (point.second - mid.second) * scaleFactor + mid.second;
     }
-
-    s.m_points = points;
 }
 
 void scale(geometrize::QuadraticBezier& s, const float scaleFactor)
 {
-    assert(0 && "TODO");
+    const float xMid = (s.m_x1 + s.m_cx + s.m_x2) / 3;
+    const float yMid = (s.m_y1 + s.m_cy + s.m_y2) / 3;
+
+    s.m_x1 = (s.m_x1 - xMid) * scaleFactor + xMid;
+    s.m_y1 = (s.m_y1 - yMid) * scaleFactor + yMid;
+    s.m_cx = (s.m_cx - xMid) * scaleFactor + xMid;
+    s.m_cy = (s.m_cy - yMid) * scaleFactor + yMid;
+    s.m_x2 = (s.m_x2 - xMid) * scaleFactor + xMid;
+    s.m_y2 = (s.m_y2 - yMid) * scaleFactor + yMid;
 }
 
 void scale(geometrize::Rectangle& s, const float scaleFactor)
@@ -612,6 +611,58 @@ void scale(geometrize::Triangle& s, const float scaleFactor)
     s.m_y3 = (s.m_y3 - yMid) * scaleFactor + yMid;
 }
 
+std::pair<float, float> getCentre(const geometrize::Shape& s)
+{
+    switch(s.getType()) {
+    case geometrize::ShapeTypes::RECTANGLE: {
+        const geometrize::Rectangle& r{static_cast<const geometrize::Rectangle&>(s)};
+        return std::make_pair((r.m_x1 + r.m_x2) / 2.0f, (r.m_y1 + r.m_y2) / 2.0f);
+    }
+    case geometrize::ShapeTypes::ROTATED_RECTANGLE: {
+        const geometrize::RotatedRectangle& r{static_cast<const geometrize::RotatedRectangle&>(s)};
+        return std::make_pair((r.m_x1 + r.m_x2) / 2.0f, (r.m_y1 + r.m_y2) / 2.0f);
+    }
+    case geometrize::ShapeTypes::TRIANGLE: {
+        const geometrize::Triangle& t{static_cast<const geometrize::Triangle&>(s)};
+        return std::make_pair((t.m_x1 + t.m_x2 + t.m_x3) / 3.0f, (t.m_y1 + t.m_y2 + t.m_y3) / 3.0f);
+    }
+    case geometrize::ShapeTypes::ELLIPSE: {
+        const geometrize::Ellipse& e{static_cast<const geometrize::Ellipse&>(s)};
+        return std::make_pair(e.m_x, e.m_y);
+    }
+    case geometrize::ShapeTypes::ROTATED_ELLIPSE: {
+        const geometrize::RotatedEllipse& e{static_cast<const geometrize::RotatedEllipse&>(s)};
+        return std::make_pair(e.m_x, e.m_y);
+    }
+    case geometrize::ShapeTypes::CIRCLE: {
+        const geometrize::Circle& c{static_cast<const geometrize::Circle&>(s)};
+        return std::make_pair(c.m_x, c.m_y);
+    }
+    case geometrize::ShapeTypes::LINE: {
+        const geometrize::Line& l{static_cast<const geometrize::Line&>(s)};
+        return std::make_pair((l.m_x1 + l.m_x2) / 2.0f, (l.m_y1 + l.m_y2) / 2.0f);
+    }
+    case geometrize::ShapeTypes::QUADRATIC_BEZIER: {
+        const geometrize::QuadraticBezier& q{static_cast<const geometrize::QuadraticBezier&>(s)};
+        return std::make_pair((q.m_x1 + q.m_cx + q.m_x2) / 3.0f, (q.m_y1 + q.m_cy + q.m_y2) / 3.0f);
+    }
+    case geometrize::ShapeTypes::POLYLINE: {
+        const geometrize::Polyline& p{static_cast<const geometrize::Polyline&>(s)};
+        float x{0.0f};
+        float y{0.0f};
+        for(const std::pair<float, float>& point : p.m_points) {
+            x += point.first;
+            y += point.second;
+        }
+        const float count{static_cast<float>((std::max)(p.m_points.size(), static_cast<std::size_t>(1U)))};
+        return std::make_pair(x / count, y / count);
+    }
+    default:
+        assert(0 && "Bad shape type");
+    }
+    return std::make_pair(0.0f, 0.0f);
+}
+
 void rotate(geometrize::Shape& s, const float angle)
 {
     switch(s.getType()) {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <utility>
 
 namespace geometrize
 {
@@ -67,6 +68,9 @@ void scale(geometrize::RotatedEllipse& s, float scaleFactor);
 void scale(geometrize::RotatedRectangle& s, float scaleFactor);
 void scale(geometrize::Triangle& s, float scaleFactor);
 
+// Gets the centre of a shape, the middle of the points that define it, which is the point the shape is scaled about
+std::pair<float, float> getCentre(const geometrize::Shape& s);
+
 // Default implementations that rotate each type of shape through an angle (those which support rotation anyway)
 void rotate(geometrize::Shape& s, float angle);
 void rotate(geometrize::Line& s, float angle);
@@ -0,0 +1,41 @@
+#include "shapespace.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "shape.h"
+#include "shapemutator.h"
+#include "../bitmap/errormap.h"
+#include "../rasterizer/scanline.h"
+
+namespace geometrize
+{
+
+void setupInSpace(geometrize::Shape& s, const geometrize::ShapeSpace& space)
+{
+    geometrize::setup(s, space.xMax - space.xMin, space.yMax - space.yMin);
+    if(space.xMin != 0 || space.yMin != 0) {
+        geometrize::translate(s, static_cast<float>(space.xMin), static_cast<float>(space.yMin));
+    }
+    if(space.errorMap) {
+        const std::pair<std::int32_t, std::int32_t> point{space.errorMap->samplePoint()};
+        const std::pair<float, float> centre{geometrize::getCentre(s)};
+        geometrize::translate(s, static_cast<float>(point.first) - centre.first, static_cast<float>(point.second) - centre.second);
+    }
+}
+
+void clipToSpace(std::vector<geometrize::Scanline>& lines, const geometrize::ShapeSpace& space)
+{
+    std::size_t count{0};
+    for(const geometrize::Scanline& line : lines) {
+        if(line.y >= space.yMin && line.x2 >= space.xMin) {
+            lines[count++] = geometrize::Scanline(line.y, (std::max)(line.x1, space.xMin), line.x2);
+        }
+    }
+    lines.resize(count);
+}
+
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "shapemutator.h"
+#include "shapetypes.h"
+#include "../rasterizer/rasterizer.h"
+#include "../rasterizer/scanline.h"
+
+namespace geometrize
+{
+class ErrorMap;
+class Shape;
+}
+
+namespace geometrize
+{
+
+/**
+ * @brief The ShapeSpace struct describes the shapes a search creates: their types, the region of the image they are set up, mutated and clipped to, and where they are placed.
+ * A search keeps one of these for the whole run rather than every shape carrying its own bound functions.
+ */
+struct ShapeSpace
+{
+    geometrize::ShapeTypes types; ///< The types of shapes to create.
+    std::int32_t xMin; ///< The left edge of the region, inclusive.
+    std::int32_t yMin; ///< The top edge of the region, inclusive.
+    std::int32_t xMax; ///< The right edge of the region, exclusive.
+    std::int32_t yMax; ///< The bottom edge of the region, exclusive.
+    std::shared_ptr<const geometrize::ErrorMap> errorMap; ///< If set, new shapes are centred on points sampled from this map, as with createErrorWeightedShapeCreator.
+};
+
+/**
+ * @brief setupInSpace Sets up a built-in shape within a space: as for an image the size of the region, then moved into the region, then onto a point sampled from the error map if there is one.
+ * @param s The shape to set up.
+ * @param space The space to set the shape up in.
+ */
+void setupInSpace(geometrize::Shape& s, const geometrize::ShapeSpace& space);
+
+/**
+ * @brief clipToSpace Clips scanlines rasterized within the bottom-right bounds of a space to its top-left bounds, in place.
+ * @param lines The scanlines.
+ * @param space The space.
+ */
+void clipToSpace(std::vector<geometrize::Scanline>& lines, const geometrize::ShapeSpace& space);
+
+/**
+ * @brief mutateInSpace Mutates a built-in shape within a space, in region coordinates. Instantiated for a concrete shape class this calls its mutator directly,
+ * for geometrize::Shape it dispatches on the type of the shape.
+ * @param s The shape to mutate.
+ * @param space The space the shape was created in.
+ */
+template<typename ShapeT>
+void mutateInSpace(ShapeT& s, const geometrize::ShapeSpace& space)
+{
+    if(space.xMin == 0 && space.yMin == 0) {
+        geometrize::mutate(s, space.xMax, space.yMax);
+        return;
+    }
+    const float x{static_cast<float>(space.xMin)};
+    const float y{static_cast<float>(space.yMin)};
+    geometrize::translate(s, -x, -y);
+    geometrize::mutate(s, space.xMax - space.xMin, space.yMax - space.yMin);
+    geometrize::translate(s, x, y);
+}
+
+/**
+ * @brief rasterizeInSpace Rasterizes a built-in shape, clipped to a space, into a vector supplied by the caller. Instantiated for a concrete shape class this calls
+ * its rasterizer directly, for geometrize::Shape it dispatches on the type of the shape.
+ * @param s The shape to rasterize.
+ * @param space The space the shape was created in.
+ * @param lines The vector to write the scanlines of the shape to, its previous contents are replaced.
+ */
+template<typename ShapeT>
+void rasterizeInSpace(const ShapeT& s, const geometrize::ShapeSpace& space, std::vector<geometrize::Scanline>& lines)
+{
+    geometrize::rasterize(s, space.xMax, space.yMax, lines);
+    if(space.xMin != 0 || space.yMin != 0) {
+        geometrize::clipToSpace(lines, space);
+    }
+}
+
+/**
+ * @brief rasterizeInSpace Rasterizes a built-in shape, clipped to a space.
+ * @param s The shape to rasterize.
+ * @param space The space the shape was created in.
+ * @return The scanlines of the shape.
+ */
+template<typename ShapeT>
+std::vector<geometrize::Scanline> rasterizeInSpace(const ShapeT& s, const geometrize::ShapeSpace& space)
+{
+    std::vector<geometrize::Scanline> lines;
+    geometrize::rasterizeInSpace(s, space, lines);
+    return lines;
+}
+
+}
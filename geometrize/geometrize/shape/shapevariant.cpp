@@ -0,0 +1,227 @@
+#include "shapevariant.h"
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "circle.h"
+#include "ellipse.h"
+#include "line.h"
+#include "polyline.h"
+#include "quadraticbezier.h"
+#include "rectangle.h"
+#include "rotatedellipse.h"
+#include "rotatedrectangle.h"
+#include "shape.h"
+#include "shapetypes.h"
+#include "triangle.h"
+
+namespace
+{
+
+/**
+ * Functions that call a function on a reference to each parameter of a built-in shape, in a fixed order.
+ */
+template<typename Function> void forEachParameter(geometrize::Circle& s, Function f) { f(s.m_x); f(s.m_y); f(s.m_r); }
+template<typename Function> void forEachParameter(geometrize::Ellipse& s, Function f) { f(s.m_x); f(s.m_y); f(s.m_rx); f(s.m_ry); }
+template<typename Function> void forEachParameter(geometrize::Line& s, Function f) { f(s.m_x1); f(s.m_y1); f(s.m_x2); f(s.m_y2); }
+template<typename Function> void forEachParameter(geometrize::QuadraticBezier& s, Function f) { f(s.m_cx); f(s.m_cy); f(s.m_x1); f(s.m_y1); f(s.m_x2); f(s.m_y2); }
+template<typename Function> void forEachParameter(geometrize::Rectangle& s, Function f) { f(s.m_x1); f(s.m_y1); f(s.m_x2); f(s.m_y2); }
+template<typename Function> void forEachParameter(geometrize::RotatedEllipse& s, Function f) { f(s.m_x); f(s.m_y); f(s.m_rx); f(s.m_ry); f(s.m_angle); }
+template<typename Function> void forEachParameter(geometrize::RotatedRectangle& s, Function f) { f(s.m_x1); f(s.m_y1); f(s.m_x2); f(s.m_y2); f(s.m_angle); }
+template<typename Function> void forEachParameter(geometrize::Triangle& s, Function f) { f(s.m_x1); f(s.m_y1); f(s.m_x2); f(s.m_y2); f(s.m_x3); f(s.m_y3); }
+template<typename Function> void forEachParameter(geometrize::Polyline& s, Function f)
+{
+    for(std::pair<float, float>& point : s.m_points) {
+        f(point.first);
+        f(point.second);
+    }
+}
+
+}
+
+namespace geometrize
+{
+
+ShapeVariant::ShapeVariant() : m_type{static_cast<geometrize::ShapeTypes>(0)}, m_custom{nullptr}, m_shape{nullptr}
+{}
+
+ShapeVariant::ShapeVariant(const geometrize::ShapeTypes type) : m_type{type}, m_custom{nullptr}, m_shape{nullptr}
+{
+    geometrize::dispatchShapeType(type, [this](auto* tag) {
+        using T = typename std::remove_pointer<decltype(tag)>::type;
+        m_shape = new(&m_storage) T();
+    });
+}
+
+ShapeVariant::ShapeVariant(const std::shared_ptr<geometrize::Shape>& shape) : m_type{static_cast<geometrize::ShapeTypes>(0)}, m_custom{shape}, m_shape{shape.get()}
+{
+    assert(shape);
+}
+
+ShapeVariant::~ShapeVariant()
+{
+    reset();
+}
+
+ShapeVariant& ShapeVariant::operator=(const geometrize::ShapeVariant& other)
+{
+    if(this == &other) {
+        return *this;
+    }
+
+    // Assign over a built-in shape of the same type in place, so e.g. polylines keep their point storage
+    if(m_type != 0 && m_type == other.m_type) {
+        geometrize::dispatchShapeType(m_type, [this, &other](auto* tag) {
+            using T = typename std::remove_pointer<decltype(tag)>::type;
+            *static_cast<T*>(m_shape) = *static_cast<const T*>(other.m_shape);
+        });
+        return *this;
+    }
+
+    reset();
+    copyFrom(other);
+    return *this;
+}
+
+ShapeVariant::ShapeVariant(const geometrize::ShapeVariant& other) : m_type{static_cast<geometrize::ShapeTypes>(0)}, m_custom{nullptr}, m_shape{nullptr}
+{
+    copyFrom(other);
+}
+
+ShapeVariant& ShapeVariant::operator=(geometrize::ShapeVariant&& other)
+{
+    if(this == &other) {
+        return *this;
+    }
+
+    if(m_type != 0 && m_type == other.m_type) {
+        geometrize::dispatchShapeType(m_type, [this, &other](auto* tag) {
+            using T = typename std::remove_pointer<decltype(tag)>::type;
+            *static_cast<T*>(m_shape) = std::move(*static_cast<T*>(other.m_shape));
+        });
+        return *this;
+    }
+
+    reset();
+    moveFrom(other);
+    return *this;
+}
+
+ShapeVariant::ShapeVariant(geometrize::ShapeVariant&& other) : m_type{static_cast<geometrize::ShapeTypes>(0)}, m_custom{nullptr}, m_shape{nullptr}
+{
+    moveFrom(other);
+}
+
+bool ShapeVariant::isEmpty() const
+{
+    return m_shape == nullptr;
+}
+
+bool ShapeVariant::isCustom() const
+{
+    return m_custom != nullptr;
+}
+
+geometrize::ShapeTypes ShapeVariant::getType() const
+{
+    assert(m_shape);
+    return m_custom ? m_custom->getType() : m_type;
+}
+
+geometrize::Shape& ShapeVariant::get()
+{
+    assert(m_shape);
+    return *m_shape;
+}
+
+const geometrize::Shape& ShapeVariant::get() const
+{
+    assert(m_shape);
+    return *m_shape;
+}
+
+const std::shared_ptr<geometrize::Shape>& ShapeVariant::getCustom() const
+{
+    return m_custom;
+}
+
+bool ShapeVariant::saveParameters(geometrize::ShapeParameters& parameters) const
+{
+    if(m_type == 0) {
+        return false;
+    }
+    if(m_type == geometrize::ShapeTypes::POLYLINE && static_cast<const geometrize::Polyline*>(m_shape)->m_points.size() * 2U > parameters.values.size()) {
+        return false;
+    }
+
+    parameters.count = 0;
+    geometrize::dispatchShapeType(m_type, [this, &parameters](auto* tag) {
+        using T = typename std::remove_pointer<decltype(tag)>::type;
+        forEachParameter(*static_cast<T*>(m_shape), [&parameters](const float& value) {
+            parameters.values[parameters.count++] = value;
+        });
+    });
+    return true;
+}
+
+void ShapeVariant::restoreParameters(const geometrize::ShapeParameters& parameters)
+{
+    assert(m_type != 0);
+    std::size_t index{0};
+    geometrize::dispatchShapeType(m_type, [this, &parameters, &index](auto* tag) {
+        using T = typename std::remove_pointer<decltype(tag)>::type;
+        forEachParameter(*static_cast<T*>(m_shape), [&parameters, &index](float& value) {
+            value = parameters.values[index++];
+        });
+    });
+    assert(index == parameters.count && "The number of parameters changed since they were saved");
+}
+
+void ShapeVariant::reset()
+{
+    if(m_type != 0) {
+        geometrize::dispatchShapeType(m_type, [this](auto* tag) {
+            using T = typename std::remove_pointer<decltype(tag)>::type;
+            static_cast<T*>(m_shape)->~T();
+        });
+    }
+    m_type = static_cast<geometrize::ShapeTypes>(0);
+    m_custom = nullptr;
+    m_shape = nullptr;
+}
+
+void ShapeVariant::copyFrom(const geometrize::ShapeVariant& other)
+{
+    assert(!m_shape);
+    if(other.m_custom) {
+        m_custom = other.m_custom->clone();
+        m_shape = m_custom.get();
+    } else if(other.m_type != 0) {
+        geometrize::dispatchShapeType(other.m_type, [this, &other](auto* tag) {
+            using T = typename std::remove_pointer<decltype(tag)>::type;
+            m_shape = new(&m_storage) T(*static_cast<const T*>(other.m_shape));
+        });
+        m_type = other.m_type;
+    }
+}
+
+void ShapeVariant::moveFrom(geometrize::ShapeVariant& other)
+{
+    assert(!m_shape);
+    if(other.m_custom) {
+        m_custom = std::move(other.m_custom);
+        m_shape = m_custom.get();
+        other.m_shape = nullptr;
+    } else if(other.m_type != 0) {
+        geometrize::dispatchShapeType(other.m_type, [this, &other](auto* tag) {
+            using T = typename std::remove_pointer<decltype(tag)>::type;
+            m_shape = new(&m_storage) T(std::move(*static_cast<T*>(other.m_shape)));
+        });
+        m_type = other.m_type;
+    }
+}
+
+}
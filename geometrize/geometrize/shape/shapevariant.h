@@ -0,0 +1,174 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+#include "circle.h"
+#include "ellipse.h"
+#include "line.h"
+#include "polyline.h"
+#include "quadraticbezier.h"
+#include "rectangle.h"
+#include "rotatedellipse.h"
+#include "rotatedrectangle.h"
+#include "shape.h"
+#include "shapetypes.h"
+#include "triangle.h"
+
+namespace geometrize
+{
+
+/**
+ * @brief The ShapeParameters struct is a snapshot of the parameters of a built-in shape, taken so a mutation can be undone in place.
+ */
+struct ShapeParameters
+{
+    std::array<float, 8> values; ///< The parameter values, in a fixed order for each type of shape.
+    std::size_t count; ///< The number of values saved.
+};
+
+/**
+ * @brief The ShapeVariant class holds one shape by value, as a tagged union of the built-in shape types. Copying a built-in shape copies its
+ * parameters in place, with no heap allocation (except for the points of a polyline, which are reused when assigning one polyline over another).
+ * The held shape's setup, mutate and rasterize functions are left empty - the search works on variants with the bounds of a geometrize::ShapeSpace instead.
+ * Shapes of user-defined types, or with custom functions, can be held as a shared pointer instead, in which case copying clones them as geometrize::State does.
+ * @author Sam Twidale (https://samcodes.co.uk/)
+ */
+class ShapeVariant
+{
+public:
+    /**
+     * @brief ShapeVariant Creates an empty variant, which holds no shape.
+     */
+    ShapeVariant();
+
+    /**
+     * @brief ShapeVariant Creates a variant holding a default-constructed built-in shape, which still needs setting up.
+     * @param type The type of shape to hold.
+     */
+    explicit ShapeVariant(geometrize::ShapeTypes type);
+
+    /**
+     * @brief ShapeVariant Creates a variant holding a custom shape, which keeps using its own setup, mutate and rasterize functions.
+     * @param shape The shape to hold, ownership is shared rather than the shape being cloned.
+     */
+    explicit ShapeVariant(const std::shared_ptr<geometrize::Shape>& shape);
+
+    ~ShapeVariant();
+    ShapeVariant& operator=(const geometrize::ShapeVariant& other);
+    ShapeVariant(const geometrize::ShapeVariant& other);
+
+    /**
+     * Moving a variant moves the held shape rather than copying it, so e.g. the points of a polyline change hands without being reallocated.
+     * The moved-from variant holds a moved-from built-in shape of the same type, or is empty if it held a custom shape.
+     */
+    ShapeVariant& operator=(geometrize::ShapeVariant&& other);
+    ShapeVariant(geometrize::ShapeVariant&& other);
+
+    /**
+     * @brief isEmpty Checks whether the variant holds a shape.
+     * @return True if the variant holds no shape.
+     */
+    bool isEmpty() const;
+
+    /**
+     * @brief isCustom Checks whether the variant holds a custom shape rather than a built-in one.
+     * @return True if the shape is held by shared pointer, with its own functions.
+     */
+    bool isCustom() const;
+
+    /**
+     * @brief getType Gets the type of the held shape, the variant must not be empty.
+     * @return The type of the held shape.
+     */
+    geometrize::ShapeTypes getType() const;
+
+    /**
+     * @brief get Gets the held shape, the variant must not be empty.
+     * @return The held shape.
+     */
+    geometrize::Shape& get();
+
+    /**
+     * @brief get Gets the held shape, the variant must not be empty.
+     * @return The held shape.
+     */
+    const geometrize::Shape& get() const;
+
+    /**
+     * @brief getCustom Gets the held custom shape.
+     * @return The custom shape, or null if the variant holds a built-in shape or is empty.
+     */
+    const std::shared_ptr<geometrize::Shape>& getCustom() const;
+
+    /**
+     * @brief saveParameters Saves the parameters of the held shape, e.g. before mutating it, so they can be restored without copying the whole shape.
+     * @param parameters The snapshot to save the parameters to.
+     * @return True if the parameters were saved. False for custom shapes and polylines with more than four points, which must be copied instead.
+     */
+    bool saveParameters(geometrize::ShapeParameters& parameters) const;
+
+    /**
+     * @brief restoreParameters Restores the parameters of the held shape to a snapshot taken by saveParameters.
+     * Mutation must not have changed the number of parameters (e.g. of points on a polyline) since.
+     * @param parameters The snapshot to restore from.
+     */
+    void restoreParameters(const geometrize::ShapeParameters& parameters);
+
+private:
+    void reset();
+    void copyFrom(const geometrize::ShapeVariant& other);
+    void moveFrom(geometrize::ShapeVariant& other);
+
+    std::aligned_union<0, geometrize::Circle, geometrize::Ellipse, geometrize::Line, geometrize::Polyline, geometrize::QuadraticBezier,
+            geometrize::Rectangle, geometrize::RotatedEllipse, geometrize::RotatedRectangle, geometrize::Triangle>::type m_storage; ///< Storage for a built-in shape.
+    geometrize::ShapeTypes m_type; ///< The type of built-in shape in the storage, 0 if there isn't one.
+    std::shared_ptr<geometrize::Shape> m_custom; ///< The custom shape, null unless the variant holds one.
+    geometrize::Shape* m_shape; ///< The held shape, in the storage or the custom shape, null if the variant is empty.
+};
+
+/**
+ * @brief dispatchShapeType Calls a function with a null pointer of the built-in shape class for a shape type, so the function can be written once for every class.
+ * @param type The shape type.
+ * @param function The function to call, taking a pointer to the shape class.
+ */
+template<typename Function>
+void dispatchShapeType(const geometrize::ShapeTypes type, Function function)
+{
+    switch(type) {
+    case geometrize::ShapeTypes::RECTANGLE:
+        function(static_cast<geometrize::Rectangle*>(nullptr));
+        break;
+    case geometrize::ShapeTypes::ROTATED_RECTANGLE:
+        function(static_cast<geometrize::RotatedRectangle*>(nullptr));
+        break;
+    case geometrize::ShapeTypes::TRIANGLE:
+        function(static_cast<geometrize::Triangle*>(nullptr));
+        break;
+    case geometrize::ShapeTypes::ELLIPSE:
+        function(static_cast<geometrize::Ellipse*>(nullptr));
+        break;
+    case geometrize::ShapeTypes::ROTATED_ELLIPSE:
+        function(static_cast<geometrize::RotatedEllipse*>(nullptr));
+        break;
+    case geometrize::ShapeTypes::CIRCLE:
+        function(static_cast<geometrize::Circle*>(nullptr));
+        break;
+    case geometrize::ShapeTypes::LINE:
+        function(static_cast<geometrize::Line*>(nullptr));
+        break;
+    case geometrize::ShapeTypes::QUADRATIC_BEZIER:
+        function(static_cast<geometrize::QuadraticBezier*>(nullptr));
+        break;
+    case geometrize::ShapeTypes::POLYLINE:
+        function(static_cast<geometrize::Polyline*>(nullptr));
+        break;
+    default:
+        assert(0 && "Bad shape type");
+    }
+}
+
+}
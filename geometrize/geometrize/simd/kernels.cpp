@@ -0,0 +1,222 @@
+#include "kernels.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "../bitmap/rgba.h"
+#include "x86kernels.h"
+
+namespace
+{
+
+/**
+ * @brief The KernelTable struct holds the set of kernel implementations for one instruction set.
+ */
+struct KernelTable
+{
+    geometrize::simd::InstructionSet instructionSet;
+    void (*accumulateColorSums)(const std::uint8_t*, const std::uint8_t*, std::size_t, geometrize::simd::ColorSums&);
+    std::int64_t (*squaredError)(const std::uint8_t*, const std::uint8_t*, std::size_t);
+    std::int64_t (*squaredErrorDelta)(const std::uint8_t*, const std::uint8_t*, const std::uint8_t*, std::size_t);
+    std::int64_t (*blendedErrorDelta)(const std::uint8_t*, const std::uint8_t*, std::size_t, const geometrize::simd::BlendColor&);
+};
+
+const KernelTable scalarKernels{
+    geometrize::simd::InstructionSet::SCALAR,
+    geometrize::simd::scalar::accumulateColorSums,
+    geometrize::simd::scalar::squaredError,
+    geometrize::simd::scalar::squaredErrorDelta,
+    geometrize::simd::scalar::blendedErrorDelta
+};
+
+#ifdef GEOMETRIZE_SIMD_X86
+const KernelTable sse41Kernels{
+    geometrize::simd::InstructionSet::SSE41,
+    geometrize::simd::sse41::accumulateColorSums,
+    geometrize::simd::sse41::squaredError,
+    geometrize::simd::sse41::squaredErrorDelta,
+    geometrize::simd::sse41::blendedErrorDelta
+};
+
+const KernelTable avx2Kernels{
+    geometrize::simd::InstructionSet::AVX2,
+    geometrize::simd::avx2::accumulateColorSums,
+    geometrize::simd::avx2::squaredError,
+    geometrize::simd::avx2::squaredErrorDelta,
+    geometrize::simd::avx2::blendedErrorDelta
+};
+
+const KernelTable avx512Kernels{
+    geometrize::simd::InstructionSet::AVX512,
+    geometrize::simd::avx512::accumulateColorSums,
+    geometrize::simd::avx512::squaredError,
+    geometrize::simd::avx512::squaredErrorDelta,
+    geometrize::simd::avx512::blendedErrorDelta
+};
+#endif
+
+const KernelTable* getKernelTable(const geometrize::simd::InstructionSet instructionSet)
+{
+    switch(instructionSet) {
+#ifdef GEOMETRIZE_SIMD_X86
+    case geometrize::simd::InstructionSet::SSE41:
+        return &sse41Kernels;
+    case geometrize::simd::InstructionSet::AVX2:
+        return &avx2Kernels;
+    case geometrize::simd::InstructionSet::AVX512:
+        return &avx512Kernels;
+#endif
+    default:
+        return &scalarKernels;
+    }
+}
+
+std::atomic<const KernelTable*>& activeKernels()
+{
+    // Detected once on first use, the CPU can't change underneath us
+    static std::atomic<const KernelTable*> kernels{getKernelTable(geometrize::simd::getBestSupportedInstructionSet())};
+    return kernels;
+}
+
+}
+
+namespace geometrize
+{
+
+namespace simd
+{
+
+geometrize::simd::BlendColor makeBlendColor(const geometrize::rgba color)
+{
+    // Same conversion to alpha-premultiplied 16-bits per channel as drawLines
+    const std::uint32_t a{color.a};
+    return geometrize::simd::BlendColor{
+        static_cast<std::uint16_t>((color.r | (static_cast<std::uint32_t>(color.r) << 8)) * a / UINT8_MAX),
+        static_cast<std::uint16_t>((color.g | (static_cast<std::uint32_t>(color.g) << 8)) * a / UINT8_MAX),
+        static_cast<std::uint16_t>((color.b | (static_cast<std::uint32_t>(color.b) << 8)) * a / UINT8_MAX),
+        static_cast<std::uint16_t>(a | (a << 8)),
+        static_cast<std::uint16_t>(UINT8_MAX - a)
+    };
+}
+
+geometrize::simd::InstructionSet getBestSupportedInstructionSet()
+{
+    const geometrize::simd::InstructionSet candidates[] = {
+        geometrize::simd::InstructionSet::AVX512,
+        geometrize::simd::InstructionSet::AVX2,
+        geometrize::simd::InstructionSet::SSE41
+    };
+    for(const geometrize::simd::InstructionSet candidate : candidates) {
+        if(isInstructionSetSupported(candidate)) {
+            return candidate;
+        }
+    }
+    return geometrize::simd::InstructionSet::SCALAR;
+}
+
+bool isInstructionSetSupported(const geometrize::simd::InstructionSet instructionSet)
+{
+    if(instructionSet == geometrize::simd::InstructionSet::SCALAR) {
+        return true;
+    }
+#ifdef GEOMETRIZE_SIMD_X86
+    return geometrize::simd::cpuSupports(instructionSet);
+#else
+    return false;
+#endif
+}
+
+geometrize::simd::InstructionSet getInstructionSet()
+{
+    return activeKernels().load()->instructionSet;
+}
+
+bool setInstructionSet(const geometrize::simd::InstructionSet instructionSet)
+{
+    if(!isInstructionSetSupported(instructionSet)) {
+        return false;
+    }
+    activeKernels().store(getKernelTable(instructionSet));
+    return true;
+}
+
+void accumulateColorSums(const std::uint8_t* const target, const std::uint8_t* const current, const std::size_t count, geometrize::simd::ColorSums& sums)
+{
+    activeKernels().load(std::memory_order_relaxed)->accumulateColorSums(target, current, count, sums);
+}
+
+std::int64_t squaredError(const std::uint8_t* const target, const std::uint8_t* const current, const std::size_t count)
+{
+    return activeKernels().load(std::memory_order_relaxed)->squaredError(target, current, count);
+}
+
+std::int64_t squaredErrorDelta(const std::uint8_t* const target, const std::uint8_t* const before, const std::uint8_t* const after, const std::size_t count)
+{
+    return activeKernels().load(std::memory_order_relaxed)->squaredErrorDelta(target, before, after, count);
+}
+
+std::int64_t blendedErrorDelta(const std::uint8_t* const target, const std::uint8_t* const current, const std::size_t count, const geometrize::simd::BlendColor& color)
+{
+    return activeKernels().load(std::memory_order_relaxed)->blendedErrorDelta(target, current, count, color);
+}
+
+namespace scalar
+{
+
+void accumulateColorSums(const std::uint8_t* const target, const std::uint8_t* const current, const std::size_t count, geometrize::simd::ColorSums& sums)
+{
+    for(std::size_t i = 0; i < count * 4U; i += 4U) {
+        sums.targetRed += target[i];
+        sums.targetGreen += target[i + 1U];
+        sums.targetBlue += target[i + 2U];
+        sums.currentRed += current[i];
+        sums.currentGreen += current[i + 1U];
+        sums.currentBlue += current[i + 2U];
+    }
+}
+
+std::int64_t squaredError(const std::uint8_t* const target, const std::uint8_t* const current, const std::size_t count)
+{
+    std::int64_t total{0};
+    for(std::size_t i = 0; i < count * 4U; i++) {
+        const std::int32_t dtc{static_cast<std::int32_t>(target[i]) - static_cast<std::int32_t>(current[i])};
+        total += dtc * dtc;
+    }
+    return total;
+}
+
+std::int64_t squaredErrorDelta(const std::uint8_t* const target, const std::uint8_t* const before, const std::uint8_t* const after, const std::size_t count)
+{
+    std::int64_t total{0};
+    for(std::size_t i = 0; i < count * 4U; i++) {
+        const std::int32_t dtb{static_cast<std::int32_t>(target[i]) - static_cast<std::int32_t>(before[i])};
+        const std::int32_t dta{static_cast<std::int32_t>(target[i]) - static_cast<std::int32_t>(after[i])};
+        total += dta * dta - dtb * dtb;
+    }
+    return total;
+}
+
+std::int64_t blendedErrorDelta(const std::uint8_t* const target, const std::uint8_t* const current, const std::size_t count, const geometrize::simd::BlendColor& color)
+{
+    // drawLines computes ((d * aa + s * m) / m) >> 8 with m = 65535 and aa = (m - sa) * 257
+    // Since s * m divides exactly and aa / m = 257 * (255 - alpha) / 255, this is (s + p + 2p / 255) >> 8 where p = d * (255 - alpha)
+    const std::uint32_t source[4]{color.red, color.green, color.blue, color.alpha};
+    const std::uint32_t inverseAlpha{color.inverseAlpha};
+
+    std::int64_t total{0};
+    for(std::size_t i = 0; i < count * 4U; i++) {
+        const std::uint32_t p{current[i] * inverseAlpha};
+        const std::int32_t blended{static_cast<std::int32_t>((source[i & 3U] + p + (2U * p) / 255U) >> 8)};
+        const std::int32_t dtc{static_cast<std::int32_t>(target[i]) - static_cast<std::int32_t>(current[i])};
+        const std::int32_t dtb{static_cast<std::int32_t>(target[i]) - blended};
+        total += dtb * dtb - dtc * dtc;
+    }
+    return total;
+}
+
+}
+
+}
+
+}
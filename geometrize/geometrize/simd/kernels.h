@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../bitmap/rgba.h"
+
+namespace geometrize
+{
+
+namespace simd
+{
+
+/**
+ * Low-level pixel kernels used by the core functions, with a portable scalar reference implementation and vectorized variants selected at runtime.
+ * All kernels operate on a contiguous run of RGBA8888 pixels and use exact integer arithmetic, so every instruction set produces bit-identical results.
+ * @author Sam Twidale (https://samcodes.co.uk/)
+ */
+
+/**
+ * @brief The InstructionSet enum specifies the instruction sets the pixel kernels can be dispatched to.
+ */
+enum class InstructionSet
+{
+    SCALAR = 0, ///< Portable scalar implementation, this is the reference that the others must match.
+    SSE41 = 1, ///< x86 SSE4.1, 128-bit vectors.
+    AVX2 = 2, ///< x86 AVX2, 256-bit vectors.
+    AVX512 = 3 ///< x86 AVX-512 (F and BW), 512-bit vectors.
+};
+
+/**
+ * @brief The ColorSums struct holds running per-channel totals of the target and current pixels covered by some scanlines.
+ */
+struct ColorSums
+{
+    std::int64_t targetRed; ///< Sum of the target red components.
+    std::int64_t targetGreen; ///< Sum of the target green components.
+    std::int64_t targetBlue; ///< Sum of the target blue components.
+    std::int64_t currentRed; ///< Sum of the current red components.
+    std::int64_t currentGreen; ///< Sum of the current green components.
+    std::int64_t currentBlue; ///< Sum of the current blue components.
+};
+
+/**
+ * @brief The BlendColor struct holds a color prepared for alpha blending, using the same fixed-point arithmetic as geometrize::drawLines.
+ */
+struct BlendColor
+{
+    std::uint16_t red; ///< Alpha-premultiplied red component (0-65535).
+    std::uint16_t green; ///< Alpha-premultiplied green component (0-65535).
+    std::uint16_t blue; ///< Alpha-premultiplied blue component (0-65535).
+    std::uint16_t alpha; ///< Alpha component (0-65535).
+    std::uint16_t inverseAlpha; ///< 255 minus the 8-bit alpha component.
+};
+
+/**
+ * @brief makeBlendColor Prepares a color for use with the blending kernels.
+ * @param color The non-premultiplied color, including alpha.
+ * @return The color in the form the blending kernels use.
+ */
+geometrize::simd::BlendColor makeBlendColor(geometrize::rgba color);
+
+/**
+ * @brief getBestSupportedInstructionSet Detects the most capable instruction set supported by the CPU (and operating system) the code is running on.
+ * @return The best supported instruction set.
+ */
+geometrize::simd::InstructionSet getBestSupportedInstructionSet();
+
+/**
+ * @brief isInstructionSetSupported Checks whether the given instruction set can be used on this machine.
+ * @param instructionSet The instruction set to check.
+ * @return True if the instruction set is available and was compiled in, else false.
+ */
+bool isInstructionSetSupported(geometrize::simd::InstructionSet instructionSet);
+
+/**
+ * @brief getInstructionSet Gets the instruction set the kernels are currently dispatched to. Defaults to the best supported one.
+ * @return The active instruction set.
+ */
+geometrize::simd::InstructionSet getInstructionSet();
+
+/**
+ * @brief setInstructionSet Overrides the instruction set the kernels are dispatched to, e.g. to force the scalar reference path.
+ * @param instructionSet The instruction set to use.
+ * @return True if the instruction set was supported and is now active, false if it is not supported (the active instruction set is left unchanged).
+ */
+bool setInstructionSet(geometrize::simd::InstructionSet instructionSet);
+
+/**
+ * @brief accumulateColorSums Adds the red, green and blue components of a run of target and current pixels to the given totals.
+ * @param target Pointer to the first target pixel.
+ * @param current Pointer to the first current pixel.
+ * @param count The number of pixels in the run.
+ * @param sums The totals to accumulate into.
+ */
+void accumulateColorSums(const std::uint8_t* target, const std::uint8_t* current, std::size_t count, geometrize::simd::ColorSums& sums);
+
+/**
+ * @brief squaredError Calculates the total squared error (over all four channels) between a run of target and current pixels.
+ * @param target Pointer to the first target pixel.
+ * @param current Pointer to the first current pixel.
+ * @param count The number of pixels in the run.
+ * @return The sum of (target - current)^2 over every channel of every pixel in the run.
+ */
+std::int64_t squaredError(const std::uint8_t* target, const std::uint8_t* current, std::size_t count);
+
+/**
+ * @brief squaredErrorDelta Calculates the change in total squared error (over all four channels) when a run of pixels changes from before to after.
+ * @param target Pointer to the first target pixel.
+ * @param before Pointer to the first pixel before the change.
+ * @param after Pointer to the first pixel after the change.
+ * @param count The number of pixels in the run.
+ * @return The sum of (target - after)^2 - (target - before)^2 over every channel of every pixel in the run.
+ */
+std::int64_t squaredErrorDelta(const std::uint8_t* target, const std::uint8_t* before, const std::uint8_t* after, std::size_t count);
+
+/**
+ * @brief blendedErrorDelta Calculates the change in total squared error (over all four channels) if a run of current pixels were blended with the given color.
+ * The blended pixels are computed in registers and never written anywhere. The result is the same as drawing the color over a copy of the pixels
+ * with geometrize::drawLines and calling squaredErrorDelta on the copy.
+ * @param target Pointer to the first target pixel.
+ * @param current Pointer to the first current pixel.
+ * @param count The number of pixels in the run.
+ * @param color The color to blend over the current pixels.
+ * @return The sum of (target - blended)^2 - (target - current)^2 over every channel of every pixel in the run.
+ */
+std::int64_t blendedErrorDelta(const std::uint8_t* target, const std::uint8_t* current, std::size_t count, const geometrize::simd::BlendColor& color);
+
+namespace scalar
+{
+
+/**
+ * @brief accumulateColorSums Scalar reference implementation of geometrize::simd::accumulateColorSums.
+ */
+void accumulateColorSums(const std::uint8_t* target, const std::uint8_t* current, std::size_t count, geometrize::simd::ColorSums& sums);
+
+/**
+ * @brief squaredError Scalar reference implementation of geometrize::simd::squaredError.
+ */
+std::int64_t squaredError(const std::uint8_t* target, const std::uint8_t* current, std::size_t count);
+
+/**
+ * @brief squaredErrorDelta Scalar reference implementation of geometrize::simd::squaredErrorDelta.
+ */
+std::int64_t squaredErrorDelta(const std::uint8_t* target, const std::uint8_t* before, const std::uint8_t* after, std::size_t count);
+
+/**
+ * @brief blendedErrorDelta Scalar reference implementation of geometrize::simd::blendedErrorDelta.
+ */
+std::int64_t blendedErrorDelta(const std::uint8_t* target, const std::uint8_t* current, std::size_t count, const geometrize::simd::BlendColor& color);
+
+}
+
+}
+
+}
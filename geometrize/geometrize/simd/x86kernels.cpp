@@ -0,0 +1,597 @@
+#include "x86kernels.h"
+
+#ifdef GEOMETRIZE_SIMD_X86
+
+#include <cstddef>
+#include <cstdint>
+
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "kernels.h"
+
+// Enables an instruction set for a single function, so the rest of the library can be built for the baseline target
+#if defined(__GNUC__) || defined(__clang__)
+#define GEOMETRIZE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define GEOMETRIZE_TARGET(isa)
+#endif
+
+namespace
+{
+
+// Maximum number of pixels the squared error kernels process before flushing their 32-bit lane accumulators to 64 bits
+// Each lane gains at most 2 * 2 * 255^2 per iteration, so this keeps well clear of overflow for every vector width
+const std::size_t errorFlushInterval{4096U};
+
+// Reorders a 128-bit lane of four RGBA pixels into planar form: rrrr gggg bbbb aaaa
+#define GEOMETRIZE_PLANAR_SHUFFLE 0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15
+
+void addColorSums(const std::uint64_t targetRG[2], const std::uint64_t targetBA[2], const std::uint64_t currentRG[2], const std::uint64_t currentBA[2], geometrize::simd::ColorSums& sums)
+{
+    sums.targetRed += static_cast<std::int64_t>(targetRG[0]);
+    sums.targetGreen += static_cast<std::int64_t>(targetRG[1]);
+    sums.targetBlue += static_cast<std::int64_t>(targetBA[0]);
+    sums.currentRed += static_cast<std::int64_t>(currentRG[0]);
+    sums.currentGreen += static_cast<std::int64_t>(currentRG[1]);
+    sums.currentBlue += static_cast<std::int64_t>(currentBA[0]);
+}
+
+// The blend kernels use the 16-bit form of the drawLines arithmetic, see geometrize::simd::scalar::blendedErrorDelta
+// With p = d * (255 - alpha), the blended value is (s + p + floor(2p / 255)) >> 8, where floor(2p / 255) = 2q + (p - 255q > 127) for q = floor(p / 255)
+// The 17-bit sum is split into high and low bytes so it can be shifted without overflowing 16-bit lanes
+
+GEOMETRIZE_TARGET("sse4.1")
+inline __m128i blendChannels(const __m128i current, const __m128i sourceHigh, const __m128i sourceLow, const __m128i inverseAlpha)
+{
+    const __m128i p = _mm_mullo_epi16(current, inverseAlpha);
+    const __m128i q = _mm_srli_epi16(_mm_mulhi_epu16(p, _mm_set1_epi16(static_cast<short>(0x8081))), 7);
+    const __m128i remainder = _mm_sub_epi16(p, _mm_mullo_epi16(q, _mm_set1_epi16(255)));
+    const __m128i x = _mm_add_epi16(p, _mm_sub_epi16(_mm_add_epi16(q, q), _mm_cmpgt_epi16(remainder, _mm_set1_epi16(127))));
+    const __m128i low = _mm_srli_epi16(_mm_add_epi16(sourceLow, _mm_and_si128(x, _mm_set1_epi16(0xFF))), 8);
+    return _mm_add_epi16(_mm_add_epi16(sourceHigh, _mm_srli_epi16(x, 8)), low);
+}
+
+GEOMETRIZE_TARGET("avx2")
+inline __m256i blendChannels(const __m256i current, const __m256i sourceHigh, const __m256i sourceLow, const __m256i inverseAlpha)
+{
+    const __m256i p = _mm256_mullo_epi16(current, inverseAlpha);
+    const __m256i q = _mm256_srli_epi16(_mm256_mulhi_epu16(p, _mm256_set1_epi16(static_cast<short>(0x8081))), 7);
+    const __m256i remainder = _mm256_sub_epi16(p, _mm256_mullo_epi16(q, _mm256_set1_epi16(255)));
+    const __m256i x = _mm256_add_epi16(p, _mm256_sub_epi16(_mm256_add_epi16(q, q), _mm256_cmpgt_epi16(remainder, _mm256_set1_epi16(127))));
+    const __m256i low = _mm256_srli_epi16(_mm256_add_epi16(sourceLow, _mm256_and_si256(x, _mm256_set1_epi16(0xFF))), 8);
+    return _mm256_add_epi16(_mm256_add_epi16(sourceHigh, _mm256_srli_epi16(x, 8)), low);
+}
+
+GEOMETRIZE_TARGET("avx512f,avx512bw")
+inline __m512i blendChannels(const __m512i current, const __m512i sourceHigh, const __m512i sourceLow, const __m512i inverseAlpha)
+{
+    const __m512i p = _mm512_mullo_epi16(current, inverseAlpha);
+    const __m512i q = _mm512_srli_epi16(_mm512_mulhi_epu16(p, _mm512_set1_epi16(static_cast<short>(0x8081))), 7);
+    const __m512i remainder = _mm512_sub_epi16(p, _mm512_mullo_epi16(q, _mm512_set1_epi16(255)));
+    const __m512i twoQ = _mm512_add_epi16(q, q);
+    const __m512i x = _mm512_add_epi16(p, _mm512_mask_add_epi16(twoQ, _mm512_cmpgt_epi16_mask(remainder, _mm512_set1_epi16(127)), twoQ, _mm512_set1_epi16(1)));
+    const __m512i low = _mm512_srli_epi16(_mm512_add_epi16(sourceLow, _mm512_and_si512(x, _mm512_set1_epi16(0xFF))), 8);
+    return _mm512_add_epi16(_mm512_add_epi16(sourceHigh, _mm512_srli_epi16(x, 8)), low);
+}
+
+}
+
+namespace geometrize
+{
+
+namespace simd
+{
+
+namespace sse41
+{
+
+GEOMETRIZE_TARGET("sse4.1")
+void accumulateColorSums(const std::uint8_t* const target, const std::uint8_t* const current, const std::size_t count, geometrize::simd::ColorSums& sums)
+{
+    const __m128i planar = _mm_setr_epi8(GEOMETRIZE_PLANAR_SHUFFLE);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i targetRG = zero;
+    __m128i targetBA = zero;
+    __m128i currentRG = zero;
+    __m128i currentBA = zero;
+
+    // Eight pixels per iteration: transpose to planar form, then sum each channel's eight bytes with psadbw
+    std::size_t i{0};
+    for(; i + 8U <= count; i += 8U) {
+        const __m128i t0 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(target + i * 4U)), planar);
+        const __m128i t1 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(target + i * 4U + 16U)), planar);
+        const __m128i c0 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(current + i * 4U)), planar);
+        const __m128i c1 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(current + i * 4U + 16U)), planar);
+        targetRG = _mm_add_epi64(targetRG, _mm_sad_epu8(_mm_unpacklo_epi32(t0, t1), zero));
+        targetBA = _mm_add_epi64(targetBA, _mm_sad_epu8(_mm_unpackhi_epi32(t0, t1), zero));
+        currentRG = _mm_add_epi64(currentRG, _mm_sad_epu8(_mm_unpacklo_epi32(c0, c1), zero));
+        currentBA = _mm_add_epi64(currentBA, _mm_sad_epu8(_mm_unpackhi_epi32(c0, c1), zero));
+    }
+
+    std::uint64_t trg[2], tba[2], crg[2], cba[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(trg), targetRG);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(tba), targetBA);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(crg), currentRG);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(cba), currentBA);
+    addColorSums(trg, tba, crg, cba, sums);
+
+    geometrize::simd::scalar::accumulateColorSums(target + i * 4U, current + i * 4U, count - i, sums);
+}
+
+GEOMETRIZE_TARGET("sse4.1")
+std::int64_t squaredError(const std::uint8_t* const target, const std::uint8_t* const current, const std::size_t count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    std::int64_t total{0};
+
+    // Four pixels per iteration, widened and squared like squaredErrorDelta
+    std::size_t i{0};
+    while(i + 4U <= count) {
+        const std::size_t end{(count - i > errorFlushInterval) ? i + errorFlushInterval : count};
+        __m128i acc = zero;
+        for(; i + 4U <= end; i += 4U) {
+            const __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i*>(target + i * 4U));
+            const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current + i * 4U));
+
+            const __m128i dtcLo = _mm_sub_epi16(_mm_cvtepu8_epi16(t), _mm_cvtepu8_epi16(c));
+            const __m128i dtcHi = _mm_sub_epi16(_mm_unpackhi_epi8(t, zero), _mm_unpackhi_epi8(c, zero));
+
+            acc = _mm_add_epi32(acc, _mm_add_epi32(_mm_madd_epi16(dtcLo, dtcLo), _mm_madd_epi16(dtcHi, dtcHi)));
+        }
+
+        std::int32_t lanes[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+        total += static_cast<std::int64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+    }
+
+    return total + geometrize::simd::scalar::squaredError(target + i * 4U, current + i * 4U, count - i);
+}
+
+GEOMETRIZE_TARGET("sse4.1")
+std::int64_t squaredErrorDelta(const std::uint8_t* const target, const std::uint8_t* const before, const std::uint8_t* const after, const std::size_t count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    std::int64_t total{0};
+
+    // Four pixels per iteration: widen to 16 bits, then square and add adjacent channels with pmaddwd
+    std::size_t i{0};
+    while(i + 4U <= count) {
+        const std::size_t end{(count - i > errorFlushInterval) ? i + errorFlushInterval : count};
+        __m128i acc = zero;
+        for(; i + 4U <= end; i += 4U) {
+            const __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i*>(target + i * 4U));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(before + i * 4U));
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(after + i * 4U));
+
+            const __m128i tLo = _mm_cvtepu8_epi16(t);
+            const __m128i tHi = _mm_unpackhi_epi8(t, zero);
+            const __m128i dtbLo = _mm_sub_epi16(tLo, _mm_cvtepu8_epi16(b));
+            const __m128i dtbHi = _mm_sub_epi16(tHi, _mm_unpackhi_epi8(b, zero));
+            const __m128i dtaLo = _mm_sub_epi16(tLo, _mm_cvtepu8_epi16(a));
+            const __m128i dtaHi = _mm_sub_epi16(tHi, _mm_unpackhi_epi8(a, zero));
+
+            acc = _mm_add_epi32(acc, _mm_sub_epi32(_mm_madd_epi16(dtaLo, dtaLo), _mm_madd_epi16(dtbLo, dtbLo)));
+            acc = _mm_add_epi32(acc, _mm_sub_epi32(_mm_madd_epi16(dtaHi, dtaHi), _mm_madd_epi16(dtbHi, dtbHi)));
+        }
+
+        std::int32_t lanes[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+        total += static_cast<std::int64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+    }
+
+    return total + geometrize::simd::scalar::squaredErrorDelta(target + i * 4U, before + i * 4U, after + i * 4U, count - i);
+}
+
+GEOMETRIZE_TARGET("sse4.1")
+std::int64_t blendedErrorDelta(const std::uint8_t* const target, const std::uint8_t* const current, const std::size_t count, const geometrize::simd::BlendColor& color)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const short rh = static_cast<short>(color.red >> 8), gh = static_cast<short>(color.green >> 8), bh = static_cast<short>(color.blue >> 8), ah = static_cast<short>(color.alpha >> 8);
+    const short rl = static_cast<short>(color.red & 0xFF), gl = static_cast<short>(color.green & 0xFF), bl = static_cast<short>(color.blue & 0xFF), al = static_cast<short>(color.alpha & 0xFF);
+    const __m128i sourceHigh = _mm_setr_epi16(rh, gh, bh, ah, rh, gh, bh, ah);
+    const __m128i sourceLow = _mm_setr_epi16(rl, gl, bl, al, rl, gl, bl, al);
+    const __m128i inverseAlpha = _mm_set1_epi16(static_cast<short>(color.inverseAlpha));
+    std::int64_t total{0};
+
+    // Four pixels per iteration, blended in 16-bit lanes and then squared and summed like squaredErrorDelta
+    std::size_t i{0};
+    while(i + 4U <= count) {
+        const std::size_t end{(count - i > errorFlushInterval) ? i + errorFlushInterval : count};
+        __m128i acc = zero;
+        for(; i + 4U <= end; i += 4U) {
+            const __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i*>(target + i * 4U));
+            const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current + i * 4U));
+
+            const __m128i tLo = _mm_cvtepu8_epi16(t);
+            const __m128i tHi = _mm_unpackhi_epi8(t, zero);
+            const __m128i cLo = _mm_cvtepu8_epi16(c);
+            const __m128i cHi = _mm_unpackhi_epi8(c, zero);
+            const __m128i dtcLo = _mm_sub_epi16(tLo, cLo);
+            const __m128i dtcHi = _mm_sub_epi16(tHi, cHi);
+            const __m128i dtbLo = _mm_sub_epi16(tLo, blendChannels(cLo, sourceHigh, sourceLow, inverseAlpha));
+            const __m128i dtbHi = _mm_sub_epi16(tHi, blendChannels(cHi, sourceHigh, sourceLow, inverseAlpha));
+
+            acc = _mm_add_epi32(acc, _mm_sub_epi32(_mm_madd_epi16(dtbLo, dtbLo), _mm_madd_epi16(dtcLo, dtcLo)));
+            acc = _mm_add_epi32(acc, _mm_sub_epi32(_mm_madd_epi16(dtbHi, dtbHi), _mm_madd_epi16(dtcHi, dtcHi)));
+        }
+
+        std::int32_t lanes[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+        total += static_cast<std::int64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+    }
+
+    return total + geometrize::simd::scalar::blendedErrorDelta(target + i * 4U, current + i * 4U, count - i, color);
+}
+
+}
+
+namespace avx2
+{
+
+GEOMETRIZE_TARGET("avx2")
+void accumulateColorSums(const std::uint8_t* const target, const std::uint8_t* const current, const std::size_t count, geometrize::simd::ColorSums& sums)
+{
+    const __m256i planar = _mm256_setr_epi8(GEOMETRIZE_PLANAR_SHUFFLE, GEOMETRIZE_PLANAR_SHUFFLE);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i targetRG = zero;
+    __m256i targetBA = zero;
+    __m256i currentRG = zero;
+    __m256i currentBA = zero;
+
+    // Sixteen pixels per iteration, the shuffles and unpacks work within 128-bit lanes so each lane ends up holding its own rg/ba sums
+    std::size_t i{0};
+    for(; i + 16U <= count; i += 16U) {
+        const __m256i t0 = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(target + i * 4U)), planar);
+        const __m256i t1 = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(target + i * 4U + 32U)), planar);
+        const __m256i c0 = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(current + i * 4U)), planar);
+        const __m256i c1 = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(current + i * 4U + 32U)), planar);
+        targetRG = _mm256_add_epi64(targetRG, _mm256_sad_epu8(_mm256_unpacklo_epi32(t0, t1), zero));
+        targetBA = _mm256_add_epi64(targetBA, _mm256_sad_epu8(_mm256_unpackhi_epi32(t0, t1), zero));
+        currentRG = _mm256_add_epi64(currentRG, _mm256_sad_epu8(_mm256_unpacklo_epi32(c0, c1), zero));
+        currentBA = _mm256_add_epi64(currentBA, _mm256_sad_epu8(_mm256_unpackhi_epi32(c0, c1), zero));
+    }
+
+    // Fold the upper 128-bit lane onto the lower one
+    std::uint64_t trg[2], tba[2], crg[2], cba[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(trg), _mm_add_epi64(_mm256_castsi256_si128(targetRG), _mm256_extracti128_si256(targetRG, 1)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(tba), _mm_add_epi64(_mm256_castsi256_si128(targetBA), _mm256_extracti128_si256(targetBA, 1)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(crg), _mm_add_epi64(_mm256_castsi256_si128(currentRG), _mm256_extracti128_si256(currentRG, 1)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(cba), _mm_add_epi64(_mm256_castsi256_si128(currentBA), _mm256_extracti128_si256(currentBA, 1)));
+    addColorSums(trg, tba, crg, cba, sums);
+
+    geometrize::simd::scalar::accumulateColorSums(target + i * 4U, current + i * 4U, count - i, sums);
+}
+
+GEOMETRIZE_TARGET("avx2")
+std::int64_t squaredError(const std::uint8_t* const target, const std::uint8_t* const current, const std::size_t count)
+{
+    std::int64_t total{0};
+
+    // Eight pixels per iteration, each 128-bit half widened separately to 16 bits
+    std::size_t i{0};
+    while(i + 8U <= count) {
+        const std::size_t end{(count - i > errorFlushInterval) ? i + errorFlushInterval : count};
+        __m256i acc = _mm256_setzero_si256();
+        for(; i + 8U <= end; i += 8U) {
+            const __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(target + i * 4U));
+            const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(current + i * 4U));
+
+            const __m256i dtcLo = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(t)), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(c)));
+            const __m256i dtcHi = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(t, 1)), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(c, 1)));
+
+            acc = _mm256_add_epi32(acc, _mm256_add_epi32(_mm256_madd_epi16(dtcLo, dtcLo), _mm256_madd_epi16(dtcHi, dtcHi)));
+        }
+
+        std::int32_t lanes[8];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+        for(const std::int32_t lane : lanes) {
+            total += lane;
+        }
+    }
+
+    return total + geometrize::simd::scalar::squaredError(target + i * 4U, current + i * 4U, count - i);
+}
+
+GEOMETRIZE_TARGET("avx2")
+std::int64_t squaredErrorDelta(const std::uint8_t* const target, const std::uint8_t* const before, const std::uint8_t* const after, const std::size_t count)
+{
+    std::int64_t total{0};
+
+    // Eight pixels per iteration, each 128-bit half widened separately to 16 bits
+    std::size_t i{0};
+    while(i + 8U <= count) {
+        const std::size_t end{(count - i > errorFlushInterval) ? i + errorFlushInterval : count};
+        __m256i acc = _mm256_setzero_si256();
+        for(; i + 8U <= end; i += 8U) {
+            const __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(target + i * 4U));
+            const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(before + i * 4U));
+            const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(after + i * 4U));
+
+            const __m256i tLo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(t));
+            const __m256i tHi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(t, 1));
+            const __m256i dtbLo = _mm256_sub_epi16(tLo, _mm256_cvtepu8_epi16(_mm256_castsi256_si128(b)));
+            const __m256i dtbHi = _mm256_sub_epi16(tHi, _mm256_cvtepu8_epi16(_mm256_extracti128_si256(b, 1)));
+            const __m256i dtaLo = _mm256_sub_epi16(tLo, _mm256_cvtepu8_epi16(_mm256_castsi256_si128(a)));
+            const __m256i dtaHi = _mm256_sub_epi16(tHi, _mm256_cvtepu8_epi16(_mm256_extracti128_si256(a, 1)));
+
+            acc = _mm256_add_epi32(acc, _mm256_sub_epi32(_mm256_madd_epi16(dtaLo, dtaLo), _mm256_madd_epi16(dtbLo, dtbLo)));
+            acc = _mm256_add_epi32(acc, _mm256_sub_epi32(_mm256_madd_epi16(dtaHi, dtaHi), _mm256_madd_epi16(dtbHi, dtbHi)));
+        }
+
+        std::int32_t lanes[8];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+        for(const std::int32_t lane : lanes) {
+            total += lane;
+        }
+    }
+
+    return total + geometrize::simd::scalar::squaredErrorDelta(target + i * 4U, before + i * 4U, after + i * 4U, count - i);
+}
+
+GEOMETRIZE_TARGET("avx2")
+std::int64_t blendedErrorDelta(const std::uint8_t* const target, const std::uint8_t* const current, const std::size_t count, const geometrize::simd::BlendColor& color)
+{
+    const short rh = static_cast<short>(color.red >> 8), gh = static_cast<short>(color.green >> 8), bh = static_cast<short>(color.blue >> 8), ah = static_cast<short>(color.alpha >> 8);
+    const short rl = static_cast<short>(color.red & 0xFF), gl = static_cast<short>(color.green & 0xFF), bl = static_cast<short>(color.blue & 0xFF), al = static_cast<short>(color.alpha & 0xFF);
+    const __m256i sourceHigh = _mm256_setr_epi16(rh, gh, bh, ah, rh, gh, bh, ah, rh, gh, bh, ah, rh, gh, bh, ah);
+    const __m256i sourceLow = _mm256_setr_epi16(rl, gl, bl, al, rl, gl, bl, al, rl, gl, bl, al, rl, gl, bl, al);
+    const __m256i inverseAlpha = _mm256_set1_epi16(static_cast<short>(color.inverseAlpha));
+    std::int64_t total{0};
+
+    // Eight pixels per iteration, each 128-bit half widened separately to 16 bits
+    std::size_t i{0};
+    while(i + 8U <= count) {
+        const std::size_t end{(count - i > errorFlushInterval) ? i + errorFlushInterval : count};
+        __m256i acc = _mm256_setzero_si256();
+        for(; i + 8U <= end; i += 8U) {
+            const __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(target + i * 4U));
+            const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(current + i * 4U));
+
+            const __m256i tLo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(t));
+            const __m256i tHi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(t, 1));
+            const __m256i cLo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(c));
+            const __m256i cHi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(c, 1));
+            const __m256i dtcLo = _mm256_sub_epi16(tLo, cLo);
+            const __m256i dtcHi = _mm256_sub_epi16(tHi, cHi);
+            const __m256i dtbLo = _mm256_sub_epi16(tLo, blendChannels(cLo, sourceHigh, sourceLow, inverseAlpha));
+            const __m256i dtbHi = _mm256_sub_epi16(tHi, blendChannels(cHi, sourceHigh, sourceLow, inverseAlpha));
+
+            acc = _mm256_add_epi32(acc, _mm256_sub_epi32(_mm256_madd_epi16(dtbLo, dtbLo), _mm256_madd_epi16(dtcLo, dtcLo)));
+            acc = _mm256_add_epi32(acc, _mm256_sub_epi32(_mm256_madd_epi16(dtbHi, dtbHi), _mm256_madd_epi16(dtcHi, dtcHi)));
+        }
+
+        std::int32_t lanes[8];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+        for(const std::int32_t lane : lanes) {
+            total += lane;
+        }
+    }
+
+    return total + geometrize::simd::scalar::blendedErrorDelta(target + i * 4U, current + i * 4U, count - i, color);
+}
+
+}
+
+// GCC's AVX-512 headers trip false positive uninitialized warnings from their internal use of _mm512_undefined_*, so they are silenced for these kernels only
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+namespace avx512
+{
+
+GEOMETRIZE_TARGET("avx512f,avx512bw")
+void accumulateColorSums(const std::uint8_t* const target, const std::uint8_t* const current, const std::size_t count, geometrize::simd::ColorSums& sums)
+{
+    const __m512i planar = _mm512_broadcast_i32x4(_mm_setr_epi8(GEOMETRIZE_PLANAR_SHUFFLE));
+    const __m512i zero = _mm512_setzero_si512();
+    __m512i targetRG = zero;
+    __m512i targetBA = zero;
+    __m512i currentRG = zero;
+    __m512i currentBA = zero;
+
+    // Thirty-two pixels per iteration, same lane-local transpose as the narrower kernels
+    std::size_t i{0};
+    for(; i + 32U <= count; i += 32U) {
+        const __m512i t0 = _mm512_shuffle_epi8(_mm512_loadu_si512(target + i * 4U), planar);
+        const __m512i t1 = _mm512_shuffle_epi8(_mm512_loadu_si512(target + i * 4U + 64U), planar);
+        const __m512i c0 = _mm512_shuffle_epi8(_mm512_loadu_si512(current + i * 4U), planar);
+        const __m512i c1 = _mm512_shuffle_epi8(_mm512_loadu_si512(current + i * 4U + 64U), planar);
+        targetRG = _mm512_add_epi64(targetRG, _mm512_sad_epu8(_mm512_unpacklo_epi32(t0, t1), zero));
+        targetBA = _mm512_add_epi64(targetBA, _mm512_sad_epu8(_mm512_unpackhi_epi32(t0, t1), zero));
+        currentRG = _mm512_add_epi64(currentRG, _mm512_sad_epu8(_mm512_unpacklo_epi32(c0, c1), zero));
+        currentBA = _mm512_add_epi64(currentBA, _mm512_sad_epu8(_mm512_unpackhi_epi32(c0, c1), zero));
+    }
+
+    // Fold the four 128-bit lanes together
+    std::uint64_t lanes[4][8];
+    _mm512_storeu_si512(lanes[0], targetRG);
+    _mm512_storeu_si512(lanes[1], targetBA);
+    _mm512_storeu_si512(lanes[2], currentRG);
+    _mm512_storeu_si512(lanes[3], currentBA);
+    std::uint64_t folded[4][2];
+    for(std::size_t v = 0; v < 4U; v++) {
+        folded[v][0] = lanes[v][0] + lanes[v][2] + lanes[v][4] + lanes[v][6];
+        folded[v][1] = lanes[v][1] + lanes[v][3] + lanes[v][5] + lanes[v][7];
+    }
+    addColorSums(folded[0], folded[1], folded[2], folded[3], sums);
+
+    geometrize::simd::scalar::accumulateColorSums(target + i * 4U, current + i * 4U, count - i, sums);
+}
+
+#undef GEOMETRIZE_PLANAR_SHUFFLE
+
+GEOMETRIZE_TARGET("avx512f,avx512bw")
+std::int64_t squaredError(const std::uint8_t* const target, const std::uint8_t* const current, const std::size_t count)
+{
+    std::int64_t total{0};
+
+    // Sixteen pixels per iteration, each 256-bit half widened separately to 16 bits
+    std::size_t i{0};
+    while(i + 16U <= count) {
+        const std::size_t end{(count - i > errorFlushInterval) ? i + errorFlushInterval : count};
+        __m512i acc = _mm512_setzero_si512();
+        for(; i + 16U <= end; i += 16U) {
+            const __m512i t = _mm512_loadu_si512(target + i * 4U);
+            const __m512i c = _mm512_loadu_si512(current + i * 4U);
+
+            const __m512i dtcLo = _mm512_sub_epi16(_mm512_cvtepu8_epi16(_mm512_castsi512_si256(t)), _mm512_cvtepu8_epi16(_mm512_castsi512_si256(c)));
+            const __m512i dtcHi = _mm512_sub_epi16(_mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(t, 1)), _mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(c, 1)));
+
+            acc = _mm512_add_epi32(acc, _mm512_add_epi32(_mm512_madd_epi16(dtcLo, dtcLo), _mm512_madd_epi16(dtcHi, dtcHi)));
+        }
+
+        std::int32_t lanes[16];
+        _mm512_storeu_si512(lanes, acc);
+        for(const std::int32_t lane : lanes) {
+            total += lane;
+        }
+    }
+
+    return total + geometrize::simd::scalar::squaredError(target + i * 4U, current + i * 4U, count - i);
+}
+
+GEOMETRIZE_TARGET("avx512f,avx512bw")
+std::int64_t squaredErrorDelta(const std::uint8_t* const target, const std::uint8_t* const before, const std::uint8_t* const after, const std::size_t count)
+{
+    std::int64_t total{0};
+
+    // Sixteen pixels per iteration, each 256-bit half widened separately to 16 bits
+    std::size_t i{0};
+    while(i + 16U <= count) {
+        const std::size_t end{(count - i > errorFlushInterval) ? i + errorFlushInterval : count};
+        __m512i acc = _mm512_setzero_si512();
+        for(; i + 16U <= end; i += 16U) {
+            const __m512i t = _mm512_loadu_si512(target + i * 4U);
+            const __m512i b = _mm512_loadu_si512(before + i * 4U);
+            const __m512i a = _mm512_loadu_si512(after + i * 4U);
+
+            const __m512i tLo = _mm512_cvtepu8_epi16(_mm512_castsi512_si256(t));
+            const __m512i tHi = _mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(t, 1));
+            const __m512i dtbLo = _mm512_sub_epi16(tLo, _mm512_cvtepu8_epi16(_mm512_castsi512_si256(b)));
+            const __m512i dtbHi = _mm512_sub_epi16(tHi, _mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(b, 1)));
+            const __m512i dtaLo = _mm512_sub_epi16(tLo, _mm512_cvtepu8_epi16(_mm512_castsi512_si256(a)));
+            const __m512i dtaHi = _mm512_sub_epi16(tHi, _mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(a, 1)));
+
+            acc = _mm512_add_epi32(acc, _mm512_sub_epi32(_mm512_madd_epi16(dtaLo, dtaLo), _mm512_madd_epi16(dtbLo, dtbLo)));
+            acc = _mm512_add_epi32(acc, _mm512_sub_epi32(_mm512_madd_epi16(dtaHi, dtaHi), _mm512_madd_epi16(dtbHi, dtbHi)));
+        }
+
+        std::int32_t lanes[16];
+        _mm512_storeu_si512(lanes, acc);
+        for(const std::int32_t lane : lanes) {
+            total += lane;
+        }
+    }
+
+    return total + geometrize::simd::scalar::squaredErrorDelta(target + i * 4U, before + i * 4U, after + i * 4U, count - i);
+}
+
+GEOMETRIZE_TARGET("avx512f,avx512bw")
+std::int64_t blendedErrorDelta(const std::uint8_t* const target, const std::uint8_t* const current, const std::size_t count, const geometrize::simd::BlendColor& color)
+{
+    // Broadcast the four 16-bit channels (one 64-bit pixel) across the register
+    const long long sourceHighPixel = static_cast<long long>((static_cast<std::uint64_t>(color.alpha >> 8) << 48) | (static_cast<std::uint64_t>(color.blue >> 8) << 32) | (static_cast<std::uint64_t>(color.green >> 8) << 16) | (color.red >> 8));
+    const long long sourceLowPixel = static_cast<long long>((static_cast<std::uint64_t>(color.alpha & 0xFF) << 48) | (static_cast<std::uint64_t>(color.blue & 0xFF) << 32) | (static_cast<std::uint64_t>(color.green & 0xFF) << 16) | (color.red & 0xFF));
+    const __m512i sourceHigh = _mm512_set1_epi64(sourceHighPixel);
+    const __m512i sourceLow = _mm512_set1_epi64(sourceLowPixel);
+    const __m512i inverseAlpha = _mm512_set1_epi16(static_cast<short>(color.inverseAlpha));
+    std::int64_t total{0};
+
+    // Sixteen pixels per iteration, each 256-bit half widened separately to 16 bits
+    std::size_t i{0};
+    while(i + 16U <= count) {
+        const std::size_t end{(count - i > errorFlushInterval) ? i + errorFlushInterval : count};
+        __m512i acc = _mm512_setzero_si512();
+        for(; i + 16U <= end; i += 16U) {
+            const __m512i t = _mm512_loadu_si512(target + i * 4U);
+            const __m512i c = _mm512_loadu_si512(current + i * 4U);
+
+            const __m512i tLo = _mm512_cvtepu8_epi16(_mm512_castsi512_si256(t));
+            const __m512i tHi = _mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(t, 1));
+            const __m512i cLo = _mm512_cvtepu8_epi16(_mm512_castsi512_si256(c));
+            const __m512i cHi = _mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(c, 1));
+            const __m512i dtcLo = _mm512_sub_epi16(tLo, cLo);
+            const __m512i dtcHi = _mm512_sub_epi16(tHi, cHi);
+            const __m512i dtbLo = _mm512_sub_epi16(tLo, blendChannels(cLo, sourceHigh, sourceLow, inverseAlpha));
+            const __m512i dtbHi = _mm512_sub_epi16(tHi, blendChannels(cHi, sourceHigh, sourceLow, inverseAlpha));
+
+            acc = _mm512_add_epi32(acc, _mm512_sub_epi32(_mm512_madd_epi16(dtbLo, dtbLo), _mm512_madd_epi16(dtcLo, dtcLo)));
+            acc = _mm512_add_epi32(acc, _mm512_sub_epi32(_mm512_madd_epi16(dtbHi, dtbHi), _mm512_madd_epi16(dtcHi, dtcHi)));
+        }
+
+        std::int32_t lanes[16];
+        _mm512_storeu_si512(lanes, acc);
+        for(const std::int32_t lane : lanes) {
+            total += lane;
+        }
+    }
+
+    return total + geometrize::simd::scalar::blendedErrorDelta(target + i * 4U, current + i * 4U, count - i, color);
+}
+
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+bool cpuSupports(const geometrize::simd::InstructionSet instructionSet)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    switch(instructionSet) {
+    case geometrize::simd::InstructionSet::SCALAR:
+        return true;
+    case geometrize::simd::InstructionSet::SSE41:
+        return __builtin_cpu_supports("sse4.1");
+    case geometrize::simd::InstructionSet::AVX2:
+        return __builtin_cpu_supports("avx2");
+    case geometrize::simd::InstructionSet::AVX512:
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+    }
+    return false;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf{info[0]};
+    if(maxLeaf < 1) {
+        return instructionSet == geometrize::simd::InstructionSet::SCALAR;
+    }
+    __cpuid(info, 1);
+    const bool sse41{(info[2] & (1 << 19)) != 0};
+    const bool osxsave{(info[2] & (1 << 27)) != 0};
+    const unsigned long long xcr0{osxsave ? _xgetbv(0) : 0ULL};
+    const bool avxState{(xcr0 & 0x6ULL) == 0x6ULL}; // XMM and YMM registers are saved by the OS
+    const bool avx512State{(xcr0 & 0xE6ULL) == 0xE6ULL}; // ...and opmask/ZMM registers too
+    int extended[4]{0, 0, 0, 0};
+    if(maxLeaf >= 7) {
+        __cpuidex(extended, 7, 0);
+    }
+
+    switch(instructionSet) {
+    case geometrize::simd::InstructionSet::SCALAR:
+        return true;
+    case geometrize::simd::InstructionSet::SSE41:
+        return sse41;
+    case geometrize::simd::InstructionSet::AVX2:
+        return avxState && (extended[1] & (1 << 5)) != 0;
+    case geometrize::simd::InstructionSet::AVX512:
+        return avx512State && (extended[1] & (1 << 16)) != 0 && (extended[1] & (1 << 30)) != 0;
+    }
+    return false;
+#else
+    return instructionSet == geometrize::simd::InstructionSet::SCALAR;
+#endif
+}
+
+}
+
+}
+
+#endif
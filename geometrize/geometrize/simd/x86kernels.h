@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "kernels.h"
+
+// The x86 kernels are compiled in on x86/x64 unless GEOMETRIZE_NO_SIMD is defined
+// They are built with per-function target attributes, so no special compiler flags are needed and the code still runs on older CPUs
+#if !defined(GEOMETRIZE_NO_SIMD) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#define GEOMETRIZE_SIMD_X86 1
+#endif
+
+#ifdef GEOMETRIZE_SIMD_X86
+
+namespace geometrize
+{
+
+namespace simd
+{
+
+/**
+ * Vectorized x86 implementations of the pixel kernels, see kernels.h for documentation.
+ * These must only be called when the corresponding instruction set is supported.
+ * @author Sam Twidale (https://samcodes.co.uk/)
+ */
+
+namespace sse41
+{
+void accumulateColorSums(const std::uint8_t* target, const std::uint8_t* current, std::size_t count, geometrize::simd::ColorSums& sums);
+std::int64_t squaredError(const std::uint8_t* target, const std::uint8_t* current, std::size_t count);
+std::int64_t squaredErrorDelta(const std::uint8_t* target, const std::uint8_t* before, const std::uint8_t* after, std::size_t count);
+std::int64_t blendedErrorDelta(const std::uint8_t* target, const std::uint8_t* current, std::size_t count, const geometrize::simd::BlendColor& color);
+}
+
+namespace avx2
+{
+void accumulateColorSums(const std::uint8_t* target, const std::uint8_t* current, std::size_t count, geometrize::simd::ColorSums& sums);
+std::int64_t squaredError(const std::uint8_t* target, const std::uint8_t* current, std::size_t count);
+std::int64_t squaredErrorDelta(const std::uint8_t* target, const std::uint8_t* before, const std::uint8_t* after, std::size_t count);
+std::int64_t blendedErrorDelta(const std::uint8_t* target, const std::uint8_t* current, std::size_t count, const geometrize::simd::BlendColor& color);
+}
+
+namespace avx512
+{
+void accumulateColorSums(const std::uint8_t* target, const std::uint8_t* current, std::size_t count, geometrize::simd::ColorSums& sums);
+std::int64_t squaredError(const std::uint8_t* target, const std::uint8_t* current, std::size_t count);
+std::int64_t squaredErrorDelta(const std::uint8_t* target, const std::uint8_t* before, const std::uint8_t* after, std::size_t count);
+std::int64_t blendedErrorDelta(const std::uint8_t* target, const std::uint8_t* current, std::size_t count, const geometrize::simd::BlendColor& color);
+}
+
+/**
+ * @brief cpuSupports Queries the CPU (and operating system) for support of the given instruction set.
+ * @param instructionSet The instruction set to query.
+ * @return True if the instruction set can be used, else false.
+ */
+bool cpuSupports(geometrize::simd::InstructionSet instructionSet);
+
+}
+
+}
+
+#endif
@@ -8,10 +8,10 @@
 namespace geometrize
 {
 
-State::State() : m_score{-1.0}, m_alpha{0}, m_shape{nullptr} {}
+State::State() : m_score{0}, m_alpha{0}, m_shape{nullptr} {}
 
 State::State(const std::shared_ptr<geometrize::Shape>& shape, const std::uint8_t alpha) :
-    m_score{-1.0}, m_alpha{alpha}, m_shape{shape}
+    m_score{0}, m_alpha{alpha}, m_shape{shape}
 {
     m_shape->setup(*m_shape);
 }
@@ -34,7 +34,7 @@ geometrize::State State::mutate()
 {
     geometrize::State oldState(*this);
     m_shape->mutate(*m_shape);
-    m_score = -1;
+    m_score = 0;
     return oldState;
 }
 
@@ -38,7 +38,7 @@ public:
      */
     geometrize::State mutate();
 
-    double m_score; ///< The score of the state, a measure of the improvement applying the state to the current bitmap will have.
+    std::int64_t m_score; ///< The score of the state, the change in total squared error applying the state to the current bitmap will make (lower is better).
     std::uint8_t m_alpha; ///< The alpha of the shape.
     std::shared_ptr<geometrize::Shape> m_shape; ///< The geometric primitive owned by the state.
 };
@@ -0,0 +1,144 @@
+#include "threadpool.h"
+
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace geometrize
+{
+
+class ThreadPool::ThreadPoolImpl
+{
+public:
+    ThreadPoolImpl(const std::size_t threadCount) : m_stopping{false}
+    {
+        assert(threadCount > 0);
+        m_threads.reserve(threadCount);
+        for(std::size_t i = 0; i < threadCount; i++) {
+            m_threads.emplace_back([this, i]() { work(i); });
+        }
+    }
+
+    ~ThreadPoolImpl()
+    {
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_stopping = true;
+        }
+        m_taskAvailable.notify_all();
+        for(std::thread& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    ThreadPoolImpl& operator=(const ThreadPoolImpl&) = delete;
+    ThreadPoolImpl(const ThreadPoolImpl&) = delete;
+
+    std::size_t getThreadCount() const
+    {
+        return m_threads.size();
+    }
+
+    void run(const std::size_t taskCount, const std::function<void(std::size_t, std::size_t)>& task)
+    {
+        if(taskCount == 0) {
+            return;
+        }
+
+        Batch batch{&task, taskCount, nullptr};
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            for(std::size_t i = 0; i < taskCount; i++) {
+                m_queue.push_back(Job{&batch, i});
+            }
+        }
+        m_taskAvailable.notify_all();
+
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_batchFinished.wait(lock, [&batch]() { return batch.remaining == 0; });
+        if(batch.error) {
+            std::rethrow_exception(batch.error);
+        }
+    }
+
+private:
+    /**
+     * @brief The Batch struct tracks the tasks submitted by one call to run(), it lives on the stack of the caller.
+     */
+    struct Batch
+    {
+        const std::function<void(std::size_t, std::size_t)>* task; ///< The function to run for each task.
+        std::size_t remaining; ///< The number of tasks that are yet to complete.
+        std::exception_ptr error; ///< The first exception thrown by a task, if any.
+    };
+
+    /**
+     * @brief The Job struct is one queued task.
+     */
+    struct Job
+    {
+        Batch* batch; ///< The batch the task belongs to.
+        std::size_t index; ///< The index of the task within the batch.
+    };
+
+    void work(const std::size_t worker)
+    {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        while(true) {
+            m_taskAvailable.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+            if(m_queue.empty()) {
+                return; // Stopping, and nothing left to do
+            }
+            const Job job{m_queue.front()};
+            m_queue.pop_front();
+            lock.unlock();
+
+            std::exception_ptr error{nullptr};
+            try {
+                (*job.batch->task)(job.index, worker);
+            } catch(...) {
+                error = std::current_exception();
+            }
+
+            lock.lock();
+            if(error && !job.batch->error) {
+                job.batch->error = error;
+            }
+            if(--job.batch->remaining == 0) {
+                m_batchFinished.notify_all();
+            }
+        }
+    }
+
+    std::vector<std::thread> m_threads; ///< The worker threads.
+    std::deque<Job> m_queue; ///< Tasks waiting for a worker.
+    std::mutex m_mutex; ///< Guards the queue, the batches and the stopping flag.
+    std::condition_variable m_taskAvailable; ///< Signalled when tasks are queued or the pool is stopping.
+    std::condition_variable m_batchFinished; ///< Signalled when the last task of a batch completes.
+    bool m_stopping; ///< Whether the pool is shutting down.
+};
+
+ThreadPool::ThreadPool(const std::size_t threadCount) : d{std::unique_ptr<ThreadPool::ThreadPoolImpl>(new ThreadPool::ThreadPoolImpl(threadCount))}
+{}
+
+ThreadPool::~ThreadPool()
+{}
+
+std::size_t ThreadPool::getThreadCount() const
+{
+    return d->getThreadCount();
+}
+
+void ThreadPool::run(const std::size_t taskCount, const std::function<void(std::size_t task, std::size_t worker)>& task)
+{
+    d->run(taskCount, task);
+}
+
+}
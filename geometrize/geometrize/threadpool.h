@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+namespace geometrize
+{
+
+/**
+ * @brief The ThreadPool class is a fixed set of worker threads that run batches of tasks. The threads are started once and reused between batches,
+ * so callers can keep per-worker scratch data (indexed by worker) alive across batches instead of reallocating it for every batch.
+ * A pool may be shared between several models, batches submitted from different threads are queued and run concurrently.
+ * @author Sam Twidale (https://samcodes.co.uk/)
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @brief ThreadPool Creates a thread pool and starts its worker threads.
+     * @param threadCount The number of worker threads, must be greater than zero.
+     */
+    explicit ThreadPool(std::size_t threadCount);
+
+    /**
+     * @brief ~ThreadPool Finishes any queued tasks, then stops and joins the worker threads.
+     */
+    ~ThreadPool();
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool(const ThreadPool&) = delete;
+
+    /**
+     * @brief getThreadCount Gets the number of worker threads in the pool.
+     * @return The number of worker threads.
+     */
+    std::size_t getThreadCount() const;
+
+    /**
+     * @brief run Runs a batch of tasks on the worker threads and waits for all of them to complete. Must not be called from within a task.
+     * If any task throws, the remaining tasks still run and the first exception is rethrown once the batch is complete.
+     * @param taskCount The number of tasks in the batch.
+     * @param task The function to run for each task, passed the index of the task (0 to taskCount - 1) and the index of the worker
+     * running it (0 to getThreadCount() - 1). A worker runs one task at a time, so tasks may use per-worker data without locking.
+     */
+    void run(std::size_t taskCount, const std::function<void(std::size_t task, std::size_t worker)>& task);
+
+private:
+    class ThreadPoolImpl;
+    std::unique_ptr<ThreadPool::ThreadPoolImpl> d;
+};
+
+}